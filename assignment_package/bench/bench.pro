@@ -0,0 +1,18 @@
+# Stand-alone performance benchmarks. Build and run in release mode:
+#   qmake bench.pro CONFIG+=release && make && ./triangulate_bench
+QT += core gui
+
+TARGET = triangulate_bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+INCLUDEPATH += ../include ../src ../src/scene
+
+SOURCES += \
+    triangulate_bench.cpp \
+    ../src/scene/triangulate.cpp
+
+HEADERS += \
+    ../src/scene/triangulate.h
@@ -0,0 +1,317 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+// Benchmarks guarded by default: traversal, transform dispatch, subtree cloning,
+// GPU upload and scene loading
+const static char* DEFAULT_FILTER = "BM_Traversal|BM_TransformDispatch|BM_CloneSubtree|BM_GridCreate|BM_SceneLoad";
+
+// Real time of every repetition of each benchmark, in nanoseconds, by benchmark name
+typedef std::map<QString, std::vector<double>> Samples;
+
+static double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    std::size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+// One-sided Mann-Whitney U test: the probability of the values in b ranking at least
+// this far above those in a if both came from the same distribution.
+// Uses the normal approximation with tie and continuity corrections, which is close
+// enough from about 8 samples each.
+static double mannWhitneyGreater(const std::vector<double>& a, const std::vector<double>& b)
+{
+    // (value, whether it is from b)
+    std::vector<std::pair<double, bool>> all;
+    all.reserve(a.size() + b.size());
+    for (double v : a) {
+        all.push_back({v, false});
+    }
+    for (double v : b) {
+        all.push_back({v, true});
+    }
+    std::sort(all.begin(), all.end());
+
+    const double n1 = a.size();
+    const double n2 = b.size();
+    const double n = n1 + n2;
+    double rankSumB = 0.0;
+    double ties = 0.0;
+    for (std::size_t i = 0; i < all.size();) {
+        std::size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        // Tied values share the average of ranks i + 1 to j
+        double rank = 0.5 * (i + 1 + j);
+        for (std::size_t k = i; k < j; k++) {
+            if (all[k].second) {
+                rankSumB += rank;
+            }
+        }
+        double t = double(j - i);
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double u = rankSumB - n2 * (n2 + 1) / 2;
+    double mean = n1 * n2 / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if (variance <= 0.0) {
+        // Every value is the same
+        return 1.0;
+    }
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+// Prints a duration in nanoseconds with a unit that keeps it readable
+static QByteArray formatTime(double ns)
+{
+    const char* units[] = {"ns", "us", "ms", "s"};
+    int unit = 0;
+    while (unit < 3 && std::abs(ns) >= 1000.0) {
+        ns /= 1000.0;
+        unit++;
+    }
+    return QByteArray::number(ns, 'f', ns < 10.0 ? 2 : 1) + " " + units[unit];
+}
+
+// Collects the timings of every repetition in Google Benchmark's JSON output.
+// Aggregates (means, medians, ...) and benchmarks that reported an error are left out.
+static Samples readSamples(const QJsonObject& results)
+{
+    Samples samples;
+    for (const QJsonValue& value : results.value("benchmarks").toArray()) {
+        QJsonObject benchmark = value.toObject();
+        if (benchmark.value("run_type").toString("iteration") != "iteration"
+                || benchmark.value("error_occurred").toBool()) {
+            continue;
+        }
+        QString name = benchmark.value("run_name").toString(benchmark.value("name").toString());
+        QString unit = benchmark.value("time_unit").toString("ns");
+        double scale = unit == "s" ? 1e9 : unit == "ms" ? 1e6 : unit == "us" ? 1e3 : 1.0;
+        samples[name].push_back(benchmark.value("real_time").toDouble() * scale);
+    }
+    return samples;
+}
+
+// Runs the benchmark executable with runs repetitions of every benchmark matching filter.
+// Repetitions are interleaved so that a slow patch of the machine affects every benchmark a bit
+// rather than one a lot. Returns an empty object and sets error on failure.
+static QJsonObject runBenchmarks(const QString& executable, int runs, const QString& filter, QString* error)
+{
+    QProcess process;
+    // Progress and the benchmark's own warnings go straight to our stderr
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    process.start(executable, {"--benchmark_filter=" + filter,
+                               "--benchmark_repetitions=" + QString::number(runs),
+                               "--benchmark_enable_random_interleaving=true",
+                               "--benchmark_format=json"});
+    if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        *error = executable + ": " + (process.error() == QProcess::FailedToStart
+                                      ? process.errorString() : QString("benchmarks failed"));
+        return QJsonObject();
+    }
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(process.readAllStandardOutput(), &parseError);
+    if (!document.isObject()) {
+        *error = executable + ": unreadable output: " + parseError.errorString();
+        return QJsonObject();
+    }
+    return document.object();
+}
+
+static QJsonObject readJson(const QString& path, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *error = path + ": " + file.errorString();
+        return QJsonObject();
+    }
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        *error = path + ": " + parseError.errorString();
+        return QJsonObject();
+    }
+    return document.object();
+}
+
+// The baseline keeps every sample, so later runs can be tested against the whole distribution
+static bool writeBaseline(const QString& path, const QJsonObject& results, QString* error)
+{
+    QJsonObject benchmarks;
+    for (const auto& entry : readSamples(results)) {
+        QJsonArray times;
+        for (double ns : entry.second) {
+            times.append(ns);
+        }
+        benchmarks[entry.first] = times;
+    }
+    QJsonObject baseline;
+    baseline["context"] = results.value("context");
+    baseline["benchmarks"] = benchmarks;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *error = path + ": " + file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(baseline).toJson());
+    if (!file.commit()) {
+        *error = path + ": " + file.errorString();
+        return false;
+    }
+    return true;
+}
+
+static Samples readBaseline(const QJsonObject& baseline)
+{
+    Samples samples;
+    QJsonObject benchmarks = baseline.value("benchmarks").toObject();
+    for (const QString& name : benchmarks.keys()) {
+        for (const QJsonValue& ns : benchmarks.value(name).toArray()) {
+            samples[name].push_back(ns.toDouble());
+        }
+    }
+    return samples;
+}
+
+// Timings from another machine or core count say nothing about the code
+static void warnIfDifferentMachine(const QJsonObject& baseline, const QJsonObject& current)
+{
+    for (const char* key : {"host_name", "num_cpus"}) {
+        if (baseline.value(key) != current.value(key)) {
+            std::printf("warning: the baseline was recorded with a different %s; re-record it on this machine\n", key);
+        }
+    }
+}
+
+// Prints one line per benchmark and returns the number of regressions.
+// A benchmark regressed if its median got more than threshold (a fraction) slower and
+// the Mann-Whitney test says that is unlikely to be noise at significance level alpha.
+static int compare(const Samples& baseline, const Samples& current, double threshold, double alpha)
+{
+    int regressions = 0;
+    std::printf("%-52s %12s %12s %9s %9s\n", "benchmark", "baseline", "current", "change", "p");
+    for (const auto& entry : current) {
+        const QString& name = entry.first;
+        auto base = baseline.find(name);
+        if (base == baseline.end()) {
+            std::printf("%-52s %12s %12s %9s %9s  new\n", qPrintable(name), "-",
+                        formatTime(median(entry.second)).constData(), "-", "-");
+            continue;
+        }
+        double before = median(base->second);
+        double after = median(entry.second);
+        double change = after / before - 1.0;
+        double pSlower = mannWhitneyGreater(base->second, entry.second);
+        double pFaster = mannWhitneyGreater(entry.second, base->second);
+
+        const char* verdict = "";
+        double p = std::min(pSlower, pFaster);
+        if (change > threshold && pSlower < alpha) {
+            verdict = "  SLOWER";
+            regressions++;
+        } else if (change < -threshold && pFaster < alpha) {
+            verdict = "  faster";
+        }
+        std::printf("%-52s %12s %12s %+8.1f%% %9.4f%s\n", qPrintable(name), formatTime(before).constData(),
+                    formatTime(after).constData(), 100.0 * change, p, verdict);
+    }
+    for (const auto& entry : baseline) {
+        if (current.find(entry.first) == current.end()) {
+            std::printf("%-52s %12s %12s %9s %9s  missing\n", qPrintable(entry.first),
+                        formatTime(median(entry.second)).constData(), "-", "-", "-");
+        }
+    }
+    return regressions;
+}
+
+// Runs the scene graph benchmarks and compares them with a recorded baseline.
+//   perfgate record [options]   saves the timings as the new baseline
+//   perfgate check [options]    exits with 1 and lists the benchmarks that got slower
+// Exits with 2 if the benchmarks can't be run or the files can't be read.
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Catches scene graph slowdowns by comparing benchmark runs with a baseline.");
+    parser.addHelpOption();
+    QCommandLineOption benchOption("bench", "Benchmark executable (default ./scenegraph_bench).",
+                                   "path", "./scenegraph_bench");
+    QCommandLineOption baselineOption("baseline", "Baseline file (default perf_baseline.json).",
+                                      "file", "perf_baseline.json");
+    QCommandLineOption runsOption("runs", "Repetitions of each benchmark (default 10).", "count", "10");
+    QCommandLineOption filterOption("filter", QString("Regular expression selecting the benchmarks (default %1).")
+                                    .arg(DEFAULT_FILTER), "regex", DEFAULT_FILTER);
+    QCommandLineOption thresholdOption("threshold", "Slowdown of the median that fails the check, in percent (default 5).",
+                                       "percent", "5");
+    QCommandLineOption alphaOption("alpha", "Significance level of the Mann-Whitney test (default 0.01).", "p", "0.01");
+    QCommandLineOption inputOption("input", "Use benchmark JSON written earlier with --benchmark_out instead of "
+                                   "running the benchmarks.", "file");
+    parser.addOption(benchOption);
+    parser.addOption(baselineOption);
+    parser.addOption(runsOption);
+    parser.addOption(filterOption);
+    parser.addOption(thresholdOption);
+    parser.addOption(alphaOption);
+    parser.addOption(inputOption);
+    parser.addPositionalArgument("command", "record or check.", "record|check");
+    parser.process(app);
+
+    QStringList args = parser.positionalArguments();
+    QString command = args.isEmpty() ? QString() : args.front();
+    int runs = parser.value(runsOption).toInt();
+    double threshold = parser.value(thresholdOption).toDouble() / 100.0;
+    double alpha = parser.value(alphaOption).toDouble();
+    if (args.size() != 1 || (command != "record" && command != "check") || runs < 2 || threshold < 0.0
+            || alpha <= 0.0 || alpha >= 1.0) {
+        parser.showHelp(2);
+    }
+
+    QString error;
+    QJsonObject results = parser.isSet(inputOption)
+            ? readJson(parser.value(inputOption), &error)
+            : runBenchmarks(parser.value(benchOption), runs, parser.value(filterOption), &error);
+    if (!error.isEmpty()) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+
+    if (command == "record") {
+        if (!writeBaseline(parser.value(baselineOption), results, &error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 2;
+        }
+        std::printf("Recorded %d benchmarks in %s\n", int(readSamples(results).size()),
+                    qPrintable(parser.value(baselineOption)));
+        return 0;
+    }
+
+    QJsonObject baseline = readJson(parser.value(baselineOption), &error);
+    if (!error.isEmpty()) {
+        std::fprintf(stderr, "%s\n", qPrintable(error));
+        return 2;
+    }
+    warnIfDifferentMachine(baseline.value("context").toObject(), results.value("context").toObject());
+    int regressions = compare(readBaseline(baseline), readSamples(results), threshold, alpha);
+    if (regressions) {
+        std::printf("\n%d benchmark(s) regressed by more than %.1f%% (p < %g)\n", regressions, 100.0 * threshold, alpha);
+        return 1;
+    }
+    std::printf("\nNo regressions\n");
+    return 0;
+}
@@ -0,0 +1,17 @@
+# Performance regression gate for the scene graph benchmarks (see scenegraph_bench.pro).
+# Record a baseline, change the code, rebuild scenegraph_bench, then check:
+#   qmake perfgate.pro && make
+#   ./perfgate record --runs 20
+#   ./perfgate check --runs 20 --threshold 5
+# check exits with 1 and prints a report when a benchmark's median got slower by more
+# than the threshold and a Mann-Whitney U test on the repetitions rules out noise.
+QT = core
+
+TARGET = perfgate
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+SOURCES += \
+    perfgate.cpp
@@ -0,0 +1,199 @@
+#include "softwarerasterizer.h"
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions_3_2_Core>
+#include <QOpenGLShaderProgram>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <thread>
+
+// Size of the rendered image
+const static int WIDTH = 1920;
+const static int HEIGHT = 1080;
+// Each measurement repeats the frame until at least this much time has passed
+const static double MIN_MEASURE_MS = 500.0;
+
+// The same flat shading as flat.vert.glsl / flat.frag.glsl, with one color per draw
+const static char* VERTEX_SHADER =
+        "#version 150\n"
+        "in vec3 vs_Pos;\n"
+        "void main() { gl_Position = vec4(vs_Pos.xy, 0, 1); }\n";
+const static char* FRAGMENT_SHADER =
+        "#version 150\n"
+        "uniform vec3 u_Color;\n"
+        "out vec3 out_Col;\n"
+        "void main() { out_Col = u_Color; }\n";
+
+// count triangles of random orientation scattered over the screen, each about size across (NDC)
+static void randomTriangles(int count, float size, std::vector<glm::vec3>& positions,
+                            std::vector<std::uint32_t>& indices)
+{
+    std::mt19937 rng(460);
+    std::uniform_real_distribution<float> center(-1.f, 1.f);
+    std::uniform_real_distribution<float> offset(-0.5f * size, 0.5f * size);
+    positions.clear();
+    indices.clear();
+    for (int i = 0; i < count; i++) {
+        glm::vec3 c(center(rng), center(rng), 1.f);
+        for (int k = 0; k < 3; k++) {
+            indices.push_back(std::uint32_t(positions.size()));
+            positions.push_back(c + glm::vec3(offset(rng), offset(rng), 0.f));
+        }
+    }
+}
+
+// Returns the average time of one call to f in milliseconds
+static double measure(const std::function<void()>& f)
+{
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        f();
+        runs++;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while (elapsed < MIN_MEASURE_MS);
+    return elapsed / runs;
+}
+
+// Renders the triangles with OpenGL into an offscreen framebuffer and reads the image back,
+// which is what a headless renderer on a machine without a GPU would do through Mesa
+class GLRenderer : public QOpenGLFunctions_3_2_Core
+{
+public:
+    bool create()
+    {
+        QSurfaceFormat format;
+        format.setVersion(3, 2);
+        format.setProfile(QSurfaceFormat::CoreProfile);
+        m_surface.setFormat(format);
+        m_surface.create();
+        m_context.setFormat(format);
+        if (!m_context.create() || !m_context.makeCurrent(&m_surface)) {
+            return false;
+        }
+        if (!initializeOpenGLFunctions()) {
+            return false;
+        }
+        m_fbo = std::make_unique<QOpenGLFramebufferObject>(WIDTH, HEIGHT);
+        m_program.addShaderFromSourceCode(QOpenGLShader::Vertex, VERTEX_SHADER);
+        m_program.addShaderFromSourceCode(QOpenGLShader::Fragment, FRAGMENT_SHADER);
+        m_program.bindAttributeLocation("vs_Pos", 0);
+        return m_program.link();
+    }
+
+    QString renderer()
+    {
+        return reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    }
+
+    // Uploads the triangles. Not part of the timed frame, since the GPU keeps them between frames.
+    void upload(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices)
+    {
+        glGenVertexArrays(1, &m_vao);
+        glBindVertexArray(m_vao);
+        glGenBuffers(2, m_buffers);
+        glBindBuffer(GL_ARRAY_BUFFER, m_buffers[0]);
+        glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_buffers[1]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        m_count = GLsizei(indices.size());
+    }
+
+    void render(std::vector<std::uint32_t>& pixels)
+    {
+        m_fbo->bind();
+        glViewport(0, 0, WIDTH, HEIGHT);
+        glClearColor(0.5f, 0.5f, 0.5f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        m_program.bind();
+        m_program.setUniformValue("u_Color", 1.f, 0.f, 0.f);
+        glBindVertexArray(m_vao);
+        glDrawElements(GL_TRIANGLES, m_count, GL_UNSIGNED_INT, nullptr);
+        pixels.resize(std::size_t(WIDTH) * HEIGHT);
+        glReadPixels(0, 0, WIDTH, HEIGHT, GL_BGRA, GL_UNSIGNED_BYTE, pixels.data());
+    }
+
+    void destroy()
+    {
+        glDeleteBuffers(2, m_buffers);
+        glDeleteVertexArrays(1, &m_vao);
+    }
+
+private:
+    QOffscreenSurface m_surface;
+    QOpenGLContext m_context;
+    std::unique_ptr<QOpenGLFramebufferObject> m_fbo;
+    QOpenGLShaderProgram m_program;
+    GLuint m_vao = 0;
+    GLuint m_buffers[2] = {0, 0};
+    GLsizei m_count = 0;
+};
+
+// Fraction of pixels that differ. OpenGL's rows start at the bottom, the rasterizer's at the top.
+static double mismatch(const std::vector<std::uint32_t>& glPixels, const std::vector<std::uint32_t>& cpuPixels)
+{
+    std::size_t different = 0;
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            std::uint32_t a = glPixels[std::size_t(HEIGHT - 1 - y) * WIDTH + x] | 0xff000000u;
+            different += a != cpuPixels[std::size_t(y) * WIDTH + x];
+        }
+    }
+    return double(different) / (double(WIDTH) * HEIGHT);
+}
+
+int main(int argc, char* argv[])
+{
+    QGuiApplication app(argc, argv);
+
+    GLRenderer gl;
+    bool haveGL = gl.create();
+    if (haveGL) {
+        std::printf("OpenGL renderer: %s\n", qPrintable(gl.renderer()));
+    } else {
+        std::printf("No OpenGL 3.2 context; only the software rasterizer is timed.\n"
+                    "Run with LIBGL_ALWAYS_SOFTWARE=1 to compare against Mesa's llvmpipe.\n");
+    }
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::printf("%10s %8s %14s %14s %14s %10s\n", "triangles", "size", "cpu 1 thr ms",
+                "cpu all thr ms", "opengl ms", "mismatch");
+    std::vector<glm::vec3> positions;
+    std::vector<std::uint32_t> indices;
+    for (int count : {1000, 100000, 1000000}) {
+        for (float size : {0.01f, 0.1f}) {
+            randomTriangles(count, size, positions, indices);
+
+            SoftwareRasterizer single(1);
+            SoftwareRasterizer parallel(threads);
+            auto cpuFrame = [&](SoftwareRasterizer& r) {
+                r.beginFrame(WIDTH, HEIGHT, glm::mat3(1.f), glm::vec3(0.5f));
+                r.drawTriangles(positions, indices, glm::mat3(1.f), glm::vec3(1.f, 0.f, 0.f));
+                r.endFrame();
+            };
+            double singleMs = measure([&] { cpuFrame(single); });
+            double parallelMs = measure([&] { cpuFrame(parallel); });
+
+            if (haveGL) {
+                std::vector<std::uint32_t> glPixels;
+                gl.upload(positions, indices);
+                double glMs = measure([&] { gl.render(glPixels); });
+                gl.destroy();
+                std::printf("%10d %8.2f %14.3f %14.3f %14.3f %9.4f%%\n", count, size, singleMs, parallelMs, glMs,
+                            100.0 * mismatch(glPixels, parallel.pixels()));
+            } else {
+                std::printf("%10d %8.2f %14.3f %14.3f %14s %10s\n", count, size, singleMs, parallelMs, "-", "-");
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+# Software rasterizer throughput, compared with whatever OpenGL driver is available.
+# Build and run in release mode; force Mesa's CPU renderer to compare against it:
+#   qmake raster_bench.pro CONFIG+=release && make && LIBGL_ALWAYS_SOFTWARE=1 ./raster_bench
+# The shapes the rasterizer draws (Polygon2D) are built on widgets
+QT += core gui widgets opengl openglwidgets
+
+TARGET = raster_bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+INCLUDEPATH += ../include ../src ../src/scene
+
+SOURCES += \
+    raster_bench.cpp \
+    ../src/renderbackend.cpp \
+    ../src/softwarerasterizer.cpp \
+    ../src/scene/node.cpp \
+    ../src/scene/nametable.cpp \
+    ../src/scene/scenechangelog.cpp \
+    ../src/scene/grid.cpp \
+    ../src/scene/polygon.cpp \
+    ../src/scene/triangulate.cpp \
+    ../src/drawable.cpp \
+    ../src/geometrybuffer.cpp \
+    ../src/openglcontext.cpp
+
+HEADERS += \
+    ../src/renderbackend.h \
+    ../src/softwarerasterizer.h \
+    ../src/openglcontext.h
@@ -0,0 +1,159 @@
+#include "softwarerasterizer.h"
+#include "scene/node.h"
+#include "scene/polygon.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+
+// Size of the rendered image. Not a multiple of the rasterizer's tiles, so partial tiles are covered too.
+const static int WIDTH = 160;
+const static int HEIGHT = 120;
+// Same background as MyGL
+const static glm::vec3 CLEAR_COLOR(0.5f, 0.5f, 0.5f);
+// The reference image, kept in golden/ next to this file. raster_golden.pro passes the
+// directory's full path; otherwise it is looked for in the working directory.
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR "golden"
+#endif
+const static char* GOLDEN_NAME = "raster_scene.ppm";
+
+// A fixed scene exercising what the rasterizer has to get exactly right: rotated and
+// scaled polygons, a triangulated concave outline, overlaps drawn in order, shared
+// edges inside every polygon's fan and the grid's lines underneath.
+// The polygons are never create()d, so they keep their vertices on the CPU.
+static uPtr<Node> buildScene(Polygon2D& diamond, Polygon2D& circle, Polygon2D& arrow)
+{
+    uPtr<Node> root = mkU<Node>("root");
+
+    Node& bar = root->addChild(mkU<ScaleNode>("bar", 7.f, 0.6f));
+    bar.setGeometry(&diamond);
+    bar.setColor(glm::vec3(1.f, 0.85f, 0.2f));
+
+    Node& left = root->addChild(mkU<TranslateNode>("left", -2.2f, 1.4f));
+    Node& tilted = left.addChild(mkU<RotateNode>("tilted", 30.f));
+    Node& box = tilted.addChild(mkU<ScaleNode>("box", 2.5f, 1.2f));
+    box.setGeometry(&diamond);
+    box.setColor(glm::vec3(0.9f, 0.1f, 0.1f));
+
+    Node& right = root->addChild(mkU<TranslateNode>("right", 1.8f, -0.9f));
+    Node& disc = right.addChild(mkU<ScaleNode>("disc", 3.f, 3.f));
+    disc.setGeometry(&circle);
+    disc.setColor(glm::vec3(0.1f, 0.3f, 0.9f));
+    Node& pointer = disc.addChild(mkU<RotateNode>("pointer", -75.f));
+    pointer.setGeometry(&arrow);
+    pointer.setColor(glm::vec3(0.2f, 0.8f, 0.3f));
+
+    return root;
+}
+
+// Renders the scene with the grid under it, as MyGL draws it
+static void render(SoftwareRasterizer& rasterizer, Node& scene)
+{
+    rasterizer.beginFrame(WIDTH, HEIGHT, glm::scale(glm::mat3(), glm::vec2(0.2f)), CLEAR_COLOR);
+    rasterizer.drawGrid();
+    rasterizer.drawScene(scene);
+    rasterizer.endFrame();
+}
+
+// Binary PPM, the simplest image format that stores exact 8-bit colors
+static bool writePPM(const std::string& path, int width, int height, const std::vector<std::uint32_t>& pixels)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (std::uint32_t p : pixels) {
+        char rgb[3] = {char((p >> 16) & 0xff), char((p >> 8) & 0xff), char(p & 0xff)};
+        file.write(rgb, 3);
+    }
+    return bool(file);
+}
+
+// Reads a file written by writePPM into 0xffRRGGBB pixels. Returns false if it can't.
+static bool readPPM(const std::string& path, int& width, int& height, std::vector<std::uint32_t>& pixels)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::string magic;
+    int maxValue = 0;
+    file >> magic >> width >> height >> maxValue;
+    file.get();
+    if (!file || magic != "P6" || maxValue != 255 || width <= 0 || height <= 0) {
+        return false;
+    }
+    pixels.resize(std::size_t(width) * height);
+    for (std::uint32_t& p : pixels) {
+        unsigned char rgb[3];
+        file.read(reinterpret_cast<char*>(rgb), 3);
+        p = 0xff000000u | (std::uint32_t(rgb[0]) << 16) | (std::uint32_t(rgb[1]) << 8) | rgb[2];
+    }
+    return bool(file);
+}
+
+// Compares a frame with the reference. On a difference, reports it and writes the frame
+// to the working directory so the two images can be looked at side by side.
+static bool matches(const char* label, const SoftwareRasterizer& rasterizer,
+                    const std::vector<std::uint32_t>& golden)
+{
+    const std::vector<std::uint32_t>& pixels = rasterizer.pixels();
+    std::size_t different = 0;
+    std::size_t first = 0;
+    for (std::size_t i = 0; i < pixels.size(); i++) {
+        if (pixels[i] != golden[i]) {
+            first = different ? first : i;
+            different++;
+        }
+    }
+    if (!different) {
+        std::printf("%s: matches\n", label);
+        return true;
+    }
+    std::string actual = std::string("raster_scene_") + label + ".ppm";
+    writePPM(actual, WIDTH, HEIGHT, pixels);
+    std::printf("%s: %zu of %d pixels differ, first at (%d, %d): %06x instead of %06x. Written to %s\n",
+                label, different, WIDTH * HEIGHT, int(first % WIDTH), int(first / WIDTH),
+                pixels[first] & 0xffffffu, golden[first] & 0xffffffu, actual.c_str());
+    return false;
+}
+
+// Pixel-exact check of SoftwareRasterizer against a reference image. Needs no GPU or display.
+// Exits with 1 if a frame differs, with one thread or with several, which would also show
+// tiles depending on which thread filled them.
+// After an intended change of the output, look at the new image and store it with --update.
+int main(int argc, char* argv[])
+{
+    const std::string goldenPath = std::string(GOLDEN_DIR) + "/" + GOLDEN_NAME;
+    bool update = argc > 1 && std::strcmp(argv[1], "--update") == 0;
+
+    Polygon2D diamond(nullptr, 4);
+    Polygon2D circle(nullptr, 32);
+    Polygon2D arrow(nullptr, {glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.1f, 0.08f, 1.f), glm::vec3(0.04f, 0.08f, 1.f),
+                              glm::vec3(0.04f, 0.45f, 1.f), glm::vec3(-0.04f, 0.45f, 1.f),
+                              glm::vec3(-0.04f, 0.08f, 1.f), glm::vec3(-0.1f, 0.08f, 1.f)});
+    uPtr<Node> scene = buildScene(diamond, circle, arrow);
+
+    SoftwareRasterizer single(1);
+    render(single, *scene);
+    if (update) {
+        if (!writePPM(goldenPath, WIDTH, HEIGHT, single.pixels())) {
+            std::printf("Can't write %s\n", goldenPath.c_str());
+            return 1;
+        }
+        std::printf("Stored %s\n", goldenPath.c_str());
+        return 0;
+    }
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint32_t> golden;
+    if (!readPPM(goldenPath, width, height, golden) || width != WIDTH || height != HEIGHT) {
+        std::printf("Can't read a %dx%d reference image from %s\n", WIDTH, HEIGHT, goldenPath.c_str());
+        return 1;
+    }
+
+    SoftwareRasterizer parallel(std::max(4u, std::thread::hardware_concurrency()));
+    render(parallel, *scene);
+    bool ok = matches("1_thread", single, golden);
+    ok = matches("threads", parallel, golden) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,35 @@
+# Pixel-exact check of the software rasterizer against golden/raster_scene.ppm.
+# Headless: needs no GPU or display. Exits with 1 if the image differs.
+#   qmake raster_golden.pro && make && ./raster_golden
+# After an intended change of the output, look at the new image and store it:
+#   ./raster_golden --update
+# The shapes the rasterizer draws (Polygon2D) are built on widgets
+QT += core gui widgets opengl openglwidgets
+
+TARGET = raster_golden
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+INCLUDEPATH += ../include ../src ../src/scene
+DEFINES += GOLDEN_DIR=\\\"$$PWD/golden\\\"
+
+SOURCES += \
+    raster_golden.cpp \
+    ../src/renderbackend.cpp \
+    ../src/softwarerasterizer.cpp \
+    ../src/scene/node.cpp \
+    ../src/scene/nametable.cpp \
+    ../src/scene/scenechangelog.cpp \
+    ../src/scene/grid.cpp \
+    ../src/scene/polygon.cpp \
+    ../src/scene/triangulate.cpp \
+    ../src/drawable.cpp \
+    ../src/geometrybuffer.cpp \
+    ../src/openglcontext.cpp
+
+HEADERS += \
+    ../src/renderbackend.h \
+    ../src/softwarerasterizer.h \
+    ../src/openglcontext.h
@@ -0,0 +1,569 @@
+#include "scene/node.h"
+#include "scene/grid.h"
+#include "scene/polygon.h"
+#include "scene/scenefile.h"
+#include "scene/scenebuilder.h"
+#include "openglcontext.h"
+#include "shaderprogram.h"
+#include "memoryreport.h"
+#include "renderqueue.h"
+#include <benchmark/benchmark.h>
+#include <QApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <utility>
+
+// How the nodes of a generated scene graph are arranged
+enum class Shape { Wide, Deep, Balanced };
+
+// Children per node of Shape::Balanced
+const static int BALANCED_FANOUT = 4;
+// Independent subtrees BM_SceneBuild splits a scene into
+const static int BUILD_SUBTREES = 64;
+// Tiles per side of the scene BM_TraversalCulled looks at part of, and the distance between them
+const static int TILES_PER_SIDE = 32;
+const static float TILE_SPACING = 100.f;
+
+// One shape shared by every generated node that draws something.
+// Never uploaded, so it needs no OpenGL context.
+static Polygon2D& sharedSquare()
+{
+    static Polygon2D square(nullptr, 4);
+    return square;
+}
+
+// The i-th node of a generated scene: the three transformation types in turn,
+// with every scale node drawing the shared square like the nodes MyGL builds
+static uPtr<Node> makeNode(int i)
+{
+    switch (i % 3) {
+    case 0:
+        return mkU<TranslateNode>("T", 0.1f * (i % 7), -0.1f * (i % 5));
+    case 1:
+        return mkU<RotateNode>("R", float(i % 360));
+    default: {
+        uPtr<Node> scale = mkU<ScaleNode>("S", 0.9f, 1.1f);
+        scale->setGeometry(&sharedSquare());
+        return scale;
+    }
+    }
+}
+
+// Builds a scene graph of count nodes (including the root) arranged as shape
+static uPtr<Node> buildScene(Shape shape, int count)
+{
+    uPtr<Node> root = mkU<Node>("root");
+    std::vector<Node*> nodes = {root.get()};
+    nodes.reserve(count);
+    for (int i = 1; i < count; i++) {
+        Node* parent = root.get();
+        switch (shape) {
+        case Shape::Wide:
+            break;
+        case Shape::Deep:
+            parent = nodes.back();
+            break;
+        case Shape::Balanced:
+            parent = nodes[(i - 1) / BALANCED_FANOUT];
+            break;
+        }
+        nodes.push_back(&parent->addChild(makeNode(i)));
+    }
+    return root;
+}
+
+// The per node work of MyGL::sceneGraphTraversal, without the render queue.
+// Iterative so Shape::Deep can't overflow the stack. Returns the number of nodes that draw something.
+static std::size_t traverse(Node& root, bool rootChanged)
+{
+    std::size_t drawn = 0;
+    // (node, its parent's world transformation, whether that was recomputed)
+    std::vector<std::pair<Node*, std::pair<const glm::mat3*, bool>>> stack;
+    const glm::mat3 identity(1.f);
+    stack.push_back({&root, {&identity, rootChanged}});
+    while (!stack.empty()) {
+        Node* node = stack.back().first;
+        const glm::mat3& parentWorld = *stack.back().second.first;
+        bool parentChanged = stack.back().second.second;
+        stack.pop_back();
+
+        bool changed = node->updateWorldTransform(parentWorld, parentChanged);
+        if (node->getPolygon()) {
+            benchmark::DoNotOptimize(node->getWorldTransform());
+            drawn++;
+        }
+        for (const uPtr<Node>& child : node->getChildren()) {
+            stack.push_back({child.get(), {&node->getWorldTransform(), changed}});
+        }
+    }
+    return drawn;
+}
+
+// A scene of count nodes spread over TILES_PER_SIDE x TILES_PER_SIDE tiles, each a
+// translation holding a Shape::Balanced subtree, like a large map seen a part at a time
+static uPtr<Node> buildTiledScene(int count)
+{
+    const int tiles = TILES_PER_SIDE * TILES_PER_SIDE;
+    uPtr<Node> root = mkU<Node>("root");
+    for (int i = 0; i < tiles; i++) {
+        Node& tile = root->addChild(mkU<TranslateNode>("tile", TILE_SPACING * (i % TILES_PER_SIDE),
+                                                       TILE_SPACING * (i / TILES_PER_SIDE)));
+        tile.addChild(buildScene(Shape::Balanced, count / tiles));
+    }
+    return root;
+}
+
+// MyGL::sceneGraphTraversal without levels of detail: skips unchanged subtrees outside
+// the queue's cull bounds, and pushes every drawn node that isn't culled. Returns the number pushed.
+static std::size_t cullTraverse(Node& node, const glm::mat3& parentWorld, bool parentChanged, RenderQueue& queue)
+{
+    if (!parentChanged && !node.subtreeBoundsDirty() && queue.isCulled(node.getSubtreeBounds())) {
+        return 0;
+    }
+    std::size_t pushed = 0;
+    bool changed = node.updateWorldTransform(parentWorld, parentChanged);
+    const glm::mat3& world = node.getWorldTransform();
+    glm::vec4 bounds(INFINITY, INFINITY, -INFINITY, -INFINITY);
+    if (Polygon2D* polygon = node.getPolygon()) {
+        bounds = RenderQueue::worldBox(world, polygon->boundsMin(), polygon->boundsMax());
+        pushed += queue.push(*polygon, world, node.getColor(), bounds);
+    }
+    for (const uPtr<Node>& child : node.getChildren()) {
+        pushed += cullTraverse(*child, world, changed, queue);
+        const glm::vec4& childBounds = child->getSubtreeBounds();
+        bounds = glm::vec4(glm::min(glm::vec2(bounds), glm::vec2(childBounds)),
+                           glm::max(glm::vec2(bounds.z, bounds.w), glm::vec2(childBounds.z, childBounds.w)));
+    }
+    node.setSubtreeBounds(bounds);
+    return pushed;
+}
+
+// A concave, star-shaped outline: n points around the origin at random distances
+static std::vector<glm::vec3> randomStar(int n)
+{
+    std::mt19937 rng(460);
+    std::uniform_real_distribution<float> radius(0.2f, 1.f);
+    std::vector<glm::vec3> positions;
+    positions.reserve(n);
+    for (int i = 0; i < n; i++) {
+        float angle = glm::radians(360.f * i / n);
+        float r = radius(rng);
+        positions.push_back(glm::vec3(r * std::cos(angle), r * std::sin(angle), 1.f));
+    }
+    return positions;
+}
+
+// The JSON of node i of a Shape::Balanced scene of count nodes, as SceneFile reads it,
+// with the same types and shapes as makeNode
+static QJsonObject sceneJsonNode(int i, int count)
+{
+    QJsonObject node;
+    switch (i % 3) {
+    case 0:
+        node["type"] = "translate";
+        node["tx"] = 0.1 * (i % 7);
+        node["ty"] = -0.1 * (i % 5);
+        break;
+    case 1:
+        node["type"] = "rotate";
+        node["angle"] = i % 360;
+        break;
+    default:
+        node["type"] = "scale";
+        node["sx"] = 0.9;
+        node["sy"] = 1.1;
+        node["geometry"] = 4;
+        break;
+    }
+    node["name"] = "N";
+    QJsonArray children;
+    for (int child = BALANCED_FANOUT * i + 1; child <= BALANCED_FANOUT * (i + 1) && child < count; child++) {
+        children.append(sceneJsonNode(child, count));
+    }
+    if (!children.isEmpty()) {
+        node["children"] = children;
+    }
+    return node;
+}
+
+static void BM_AddChild(benchmark::State& state)
+{
+    const int count = int(state.range(0));
+    for (auto _ : state) {
+        uPtr<Node> parent = mkU<Node>("parent");
+        for (int i = 0; i < count; i++) {
+            parent->addChild(makeNode(i));
+        }
+        state.PauseTiming();
+        parent.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AddChild)->Arg(16)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_CopyConstructor(benchmark::State& state, Shape shape)
+{
+    const int count = int(state.range(0));
+    uPtr<Node> scene = buildScene(shape, count);
+    for (auto _ : state) {
+        uPtr<Node> copy = mkU<Node>(*scene);
+        benchmark::DoNotOptimize(copy.get());
+        state.PauseTiming();
+        copy.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_CopyConstructor, wide, Shape::Wide)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_CAPTURE(BM_CopyConstructor, balanced, Shape::Balanced)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_CAPTURE(BM_CopyConstructor, deep, Shape::Deep)->Arg(1 << 10)->Arg(1 << 13);
+
+// Copies a subtree the way the copy constructor did before Node::clone(): finding each
+// node's class with a chain of dynamic_casts and adding the copies one child at a time.
+// The baseline BM_CloneSubtree compares cloneSubtree() with.
+static uPtr<Node> cloneByDynamicCast(const Node& node)
+{
+    uPtr<Node> copy;
+    if (const TranslateNode* tn = dynamic_cast<const TranslateNode*>(&node)) {
+        copy = mkU<TranslateNode>(node.getName(), tn->getTX(), tn->getTY());
+    } else if (const RotateNode* rn = dynamic_cast<const RotateNode*>(&node)) {
+        copy = mkU<RotateNode>(node.getName(), rn->getRotate());
+    } else if (const ScaleNode* sn = dynamic_cast<const ScaleNode*>(&node)) {
+        copy = mkU<ScaleNode>(node.getName(), sn->getSX(), sn->getSY());
+    } else {
+        copy = mkU<Node>(node.getName());
+    }
+    copy->setColor(node.getColor());
+    copy->setGeometry(node.getPolygon());
+    for (const uPtr<Node>& child : node.getChildren()) {
+        copy->addChild(cloneByDynamicCast(*child));
+    }
+    return copy;
+}
+
+// Duplicating a branch, as Edit > Duplicate Node does. typeTagged = false copies it
+// through cloneByDynamicCast instead, for comparison.
+static void BM_CloneSubtree(benchmark::State& state, Shape shape, bool typeTagged)
+{
+    const int count = int(state.range(0));
+    uPtr<Node> branch = buildScene(shape, count);
+    for (auto _ : state) {
+        uPtr<Node> copy = typeTagged ? branch->cloneSubtree() : cloneByDynamicCast(*branch);
+        benchmark::DoNotOptimize(copy.get());
+        state.PauseTiming();
+        copy.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_CloneSubtree, wide, Shape::Wide, true)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CloneSubtree, balanced, Shape::Balanced, true)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CloneSubtree, wide_dynamic_cast, Shape::Wide, false)->Arg(50000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_CloneSubtree, balanced_dynamic_cast, Shape::Balanced, false)
+    ->Arg(50000)->Unit(benchmark::kMillisecond);
+
+static void BM_ComputeTransformationMatrix(benchmark::State& state, std::function<uPtr<Node>()> make)
+{
+    uPtr<Node> node = make();
+    // Through a pointer to the base, like the scene graph calls it
+    Node* base = node.get();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base->computeTransformationMatrix());
+    }
+}
+BENCHMARK_CAPTURE(BM_ComputeTransformationMatrix, plain, [] { return mkU<Node>("N"); });
+BENCHMARK_CAPTURE(BM_ComputeTransformationMatrix, translate,
+                  []() -> uPtr<Node> { return mkU<TranslateNode>("T", 1.f, 2.f); });
+BENCHMARK_CAPTURE(BM_ComputeTransformationMatrix, rotate,
+                  []() -> uPtr<Node> { return mkU<RotateNode>("R", 30.f); });
+BENCHMARK_CAPTURE(BM_ComputeTransformationMatrix, scale,
+                  []() -> uPtr<Node> { return mkU<ScaleNode>("S", 2.f, 0.5f); });
+
+// The transform pass of a frame in which every node changed, over the nodes in traversal
+// order. Both cases read and write the world transformations in the same array, so that
+// only the per node dispatch differs between them:
+// typeTagged = true goes through localTransformation(), which switches on the node's type;
+// false calls the virtual computeTransformationMatrix() through the base, as before the tag.
+static void BM_TransformDispatch(benchmark::State& state, bool typeTagged)
+{
+    const int count = int(state.range(0));
+    uPtr<Node> scene = buildScene(Shape::Balanced, count);
+    // Pre-order, so every parent comes before its children
+    std::vector<Node*> nodes;
+    std::vector<int> parents;
+    std::vector<std::pair<Node*, int>> stack = {{scene.get(), -1}};
+    while (!stack.empty()) {
+        std::pair<Node*, int> entry = stack.back();
+        stack.pop_back();
+        int index = int(nodes.size());
+        nodes.push_back(entry.first);
+        parents.push_back(entry.second);
+        for (const uPtr<Node>& child : entry.first->getChildren()) {
+            stack.push_back({child.get(), index});
+        }
+    }
+    const glm::mat3 identity(1.f);
+    std::vector<glm::mat3> worlds(nodes.size());
+    for (auto _ : state) {
+        if (typeTagged) {
+            for (std::size_t i = 0; i < nodes.size(); i++) {
+                const glm::mat3& parentWorld = parents[i] < 0 ? identity : worlds[parents[i]];
+                worlds[i] = parentWorld * nodes[i]->localTransformation();
+            }
+        } else {
+            for (std::size_t i = 0; i < nodes.size(); i++) {
+                const glm::mat3& parentWorld = parents[i] < 0 ? identity : worlds[parents[i]];
+                worlds[i] = parentWorld * nodes[i]->computeTransformationMatrix();
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_TransformDispatch, type_tag, true)->Arg(50000)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_TransformDispatch, virtual_call, false)->Arg(50000)->Arg(1 << 20);
+
+// rootChanged = true recomputes every world transformation, as after an edit of the root;
+// false is a frame in which nothing changed and every cached transformation is reused
+static void BM_Traversal(benchmark::State& state, Shape shape, bool rootChanged)
+{
+    const int count = int(state.range(0));
+    uPtr<Node> scene = buildScene(shape, count);
+    traverse(*scene, true);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(traverse(*scene, rootChanged));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_Traversal, wide_all_dirty, Shape::Wide, true)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Traversal, balanced_all_dirty, Shape::Balanced, true)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Traversal, deep_all_dirty, Shape::Deep, true)->Arg(1 << 10)->Arg(1 << 13);
+BENCHMARK_CAPTURE(BM_Traversal, wide_clean, Shape::Wide, false)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Traversal, balanced_clean, Shape::Balanced, false)->Arg(1 << 10)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_CAPTURE(BM_Traversal, deep_clean, Shape::Deep, false)->Arg(1 << 10)->Arg(1 << 13);
+
+// An unchanged frame of a tiled scene. tilesInView = TILES_PER_SIDE sees everything, so every
+// node is visited; fewer looks at that many tiles per side, and the subtrees of the tiles
+// out of view are skipped whole. The items counted are the scene's nodes either way.
+static void BM_TraversalCulled(benchmark::State& state, int tilesInView)
+{
+    const int count = int(state.range(0));
+    uPtr<Node> scene = buildTiledScene(count);
+    RenderQueue queue;
+    // Stores every subtree's bounds, as the first frame of MyGL does
+    cullTraverse(*scene, glm::mat3(1.f), true, queue);
+    float viewSize = TILE_SPACING * tilesInView;
+    queue.setCullBounds(glm::vec2(-0.5f * TILE_SPACING), glm::vec2(viewSize - 0.5f * TILE_SPACING));
+    std::size_t drawn = 0;
+    for (auto _ : state) {
+        queue.clear();
+        drawn = cullTraverse(*scene, glm::mat3(1.f), false, queue);
+        benchmark::DoNotOptimize(drawn);
+    }
+    state.counters["drawn"] = double(drawn);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_TraversalCulled, all_in_view, TILES_PER_SIDE)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraversalCulled, quarter_in_view, TILES_PER_SIDE / 2)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_TraversalCulled, few_in_view, 2)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+
+// Parsing a scene file and building its graph, as ThumbnailBatch does
+static void BM_SceneLoad(benchmark::State& state)
+{
+    const int count = int(state.range(0));
+    QJsonObject file;
+    file["root"] = sceneJsonNode(0, count);
+    QByteArray json = QJsonDocument(file).toJson(QJsonDocument::Compact);
+    for (auto _ : state) {
+        GeometryRegistry geometry(nullptr);
+        uPtr<Node> root = SceneFile::parse(json, geometry);
+        benchmark::DoNotOptimize(root.get());
+        state.PauseTiming();
+        root.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_SceneLoad)->Arg(1 << 10)->Arg(1 << 16);
+
+// Building a balanced scene as BUILD_SUBTREES subtrees with SceneBuilder on range(1) threads.
+// One thread is the serial baseline. Wall time, since the work is spread over threads.
+static void BM_SceneBuild(benchmark::State& state)
+{
+    const int count = int(state.range(0));
+    SceneBuilder builder(unsigned(state.range(1)));
+    for (auto _ : state) {
+        uPtr<Node> root = mkU<Node>("root");
+        builder.buildInto(*root, BUILD_SUBTREES, [count](int, int subtrees) {
+            return buildScene(Shape::Balanced, count / subtrees);
+        });
+        benchmark::DoNotOptimize(root.get());
+        state.PauseTiming();
+        root.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_SceneBuild)->ArgNames({"nodes", "threads"})
+    ->Args({1 << 20, 1})->Args({1 << 20, 2})->Args({1 << 20, 4})->Args({1 << 20, 8})
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// The memory a scene takes rather than a time: builds one and reports its bytes per node
+// as counters, broken down as in MemoryReport. The time is that of building the scene.
+// On 64-bit builds: 128 bytes per node for wide and balanced scenes (120 in the node, 8 of
+// child arrays) and 120 for deep ones; 8 less each with packed colors.
+static void BM_SceneMemory(benchmark::State& state, Shape shape)
+{
+    const int count = int(state.range(0));
+    MemoryReport report;
+    for (auto _ : state) {
+        uPtr<Node> scene = buildScene(shape, count);
+        state.PauseTiming();
+        report = MemoryReport();
+        report.addScene(*scene);
+        scene.reset();
+        state.ResumeTiming();
+    }
+    const double nodes = double(report.nodeCount);
+    state.counters["bytes_per_node"] = report.sceneBytes() / nodes;
+    state.counters["node"] = report.nodeBytes / nodes;
+    state.counters["children"] = report.childrenBytes / nodes;
+    state.counters["names"] = double(report.nameBytes);
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK_CAPTURE(BM_SceneMemory, wide, Shape::Wide)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SceneMemory, balanced, Shape::Balanced)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SceneMemory, deep, Shape::Deep)->Arg(1 << 13)->Unit(benchmark::kMillisecond);
+
+// Regular polygons are fanned out without triangulating
+static void BM_Polygon2DRegular(benchmark::State& state)
+{
+    const int sides = int(state.range(0));
+    for (auto _ : state) {
+        Polygon2D polygon(nullptr, sides);
+        benchmark::DoNotOptimize(polygon.indices().data());
+    }
+    state.SetItemsProcessed(state.iterations() * sides);
+}
+BENCHMARK(BM_Polygon2DRegular)->Arg(4)->Arg(64)->Arg(4096);
+
+// Arbitrary outlines go through triangulate()
+static void BM_Polygon2DTriangulated(benchmark::State& state)
+{
+    std::vector<glm::vec3> star = randomStar(int(state.range(0)));
+    for (auto _ : state) {
+        Polygon2D polygon(nullptr, star);
+        benchmark::DoNotOptimize(polygon.indices().data());
+    }
+    state.SetItemsProcessed(state.iterations() * star.size());
+}
+BENCHMARK(BM_Polygon2DTriangulated)->Arg(16)->Arg(256)->Arg(4096);
+
+// Gives the benchmarks that upload geometry a current OpenGL context.
+// The widget is never drawn to; it only owns the context.
+class BenchContext : public OpenGLContext
+{
+public:
+    BenchContext() : OpenGLContext(nullptr), m_ready(false) {}
+
+    void initializeGL() override
+    {
+        m_ready = initializeOpenGLFunctions();
+    }
+
+    // True if a 3.2 core context could be created and is current
+    bool ready()
+    {
+        if (!isValid()) {
+            // Initializes the widget's context if it wasn't yet
+            grabFramebuffer();
+        }
+        if (!m_ready || !isValid()) {
+            return false;
+        }
+        makeCurrent();
+        return true;
+    }
+
+private:
+    bool m_ready;
+};
+
+static void BM_GridCreate(benchmark::State& state, BenchContext* context)
+{
+    if (!context->ready()) {
+        state.SkipWithError("no OpenGL 3.2 context");
+        return;
+    }
+    Grid grid(context);
+    for (auto _ : state) {
+        grid.create();
+        // Wait for the upload itself, not just for the driver to take a copy
+        context->glFinish();
+        grid.destroy();
+    }
+}
+
+// Setting up prog_flat as MyGL does. Cold compiles and links every time, with the binary
+// cache turned off; warm loads the binary a previous iteration stored. Drivers may keep
+// a cache of their own (for Mesa, set MESA_SHADER_CACHE_DISABLE=true for a true cold start).
+static void BM_ShaderCreate(benchmark::State& state, BenchContext* context, bool warm)
+{
+    if (!context->ready()) {
+        state.SkipWithError("no OpenGL 3.2 context");
+        return;
+    }
+    if (warm) {
+        qunsetenv("SCENEGRAPH_NO_SHADER_CACHE");
+    } else {
+        qputenv("SCENEGRAPH_NO_SHADER_CACHE", "1");
+    }
+    auto createAndDelete = [context]() {
+        ShaderProgram prog(context);
+        prog.m_vertShader = prog.m_fragShader = 0;
+        prog.create(":/glsl/flat.vert.glsl", ":/glsl/flat.frag.glsl");
+        // Linking may finish in the background; wait for it like drawing with it would
+        context->glFinish();
+        context->glDeleteProgram(prog.m_prog);
+        context->glDeleteShader(prog.m_vertShader);
+        context->glDeleteShader(prog.m_fragShader);
+    };
+    // Fills the cache, so the warm runs measure loading it
+    createAndDelete();
+    for (auto _ : state) {
+        createAndDelete();
+    }
+    qunsetenv("SCENEGRAPH_NO_SHADER_CACHE");
+}
+
+int main(int argc, char* argv[])
+{
+    // Run headless unless told otherwise
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    BenchContext context;
+    context.resize(64, 64);
+    context.show();
+    benchmark::RegisterBenchmark("BM_GridCreate", BM_GridCreate, &context);
+    benchmark::RegisterBenchmark("BM_ShaderCreate/cold", BM_ShaderCreate, &context, false)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("BM_ShaderCreate/warm", BM_ShaderCreate, &context, true)
+        ->Unit(benchmark::kMillisecond);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
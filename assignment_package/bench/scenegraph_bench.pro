@@ -0,0 +1,45 @@
+# Google Benchmark suite for the scene graph's building blocks. Needs libbenchmark
+# (e.g. the libbenchmark-dev package). Runs headless on Qt's offscreen platform.
+# Build in release mode and write machine-readable results for tracking:
+#   qmake scenegraph_bench.pro CONFIG+=release && make
+#   ./scenegraph_bench --benchmark_out=results.json --benchmark_out_format=json
+# Grid::create and the shader benchmarks need an OpenGL context, which is a widget
+QT += core gui widgets opengl openglwidgets
+
+TARGET = scenegraph_bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG += c++1z
+
+INCLUDEPATH += ../include ../src ../src/scene
+LIBS += -lbenchmark -lpthread
+
+SOURCES += \
+    scenegraph_bench.cpp \
+    ../src/scene/node.cpp \
+    ../src/scene/nametable.cpp \
+    ../src/scene/scenechangelog.cpp \
+    ../src/scene/grid.cpp \
+    ../src/scene/polygon.cpp \
+    ../src/scene/triangulate.cpp \
+    ../src/scene/geometryregistry.cpp \
+    ../src/scene/scenefile.cpp \
+    ../src/scene/scenebuilder.cpp \
+    ../src/drawable.cpp \
+    ../src/geometrybuffer.cpp \
+    ../src/openglcontext.cpp \
+    ../src/shaderprogram.cpp \
+    ../src/programbinarycache.cpp \
+    ../src/backgroundshadercompiler.cpp \
+    ../src/renderqueue.cpp \
+    ../src/memoryreport.cpp
+
+HEADERS += \
+    ../src/openglcontext.h \
+    ../src/shaderprogram.h \
+    ../src/memoryreport.h \
+    ../src/renderqueue.h
+
+# The shaders BM_ShaderCreate builds
+RESOURCES += ../glsl.qrc
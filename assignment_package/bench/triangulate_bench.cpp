@@ -0,0 +1,63 @@
+#include "scene/triangulate.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <random>
+
+// Ear clipping is O(n^2), so it is only timed up to this many vertices
+const static int MAX_EAR_CLIPPING_VERTICES = 10000;
+// Each measurement repeats the call until at least this much time has passed
+const static double MIN_MEASURE_MS = 200.0;
+
+// A concave, star-shaped outline: n points around the origin at random distances
+static std::vector<glm::vec3> randomStar(int n, std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> radius(0.2f, 1.f);
+    std::vector<glm::vec3> positions;
+    positions.reserve(n);
+    for (int i = 0; i < n; i++) {
+        float angle = glm::radians(360.f * i / n);
+        float r = radius(rng);
+        positions.push_back(glm::vec3(r * std::cos(angle), r * std::sin(angle), 1.f));
+    }
+    return positions;
+}
+
+// Returns the average time of one call to f in milliseconds
+static double measure(const std::function<std::size_t()>& f)
+{
+    using Clock = std::chrono::steady_clock;
+    int runs = 0;
+    std::size_t sink = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        sink += f();
+        runs++;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    } while (elapsed < MIN_MEASURE_MS);
+    return sink ? elapsed / runs : 0.0;
+}
+
+int main()
+{
+    std::mt19937 rng(460);
+    std::printf("%10s %16s %16s %16s\n", "vertices", "triangulate ms", "monotone ms", "ear clipping ms");
+    for (int n : {10, 100, 1000, 10000, 100000}) {
+        std::vector<glm::vec3> star = randomStar(n, rng);
+        if (triangulate(star).size() != 3 * std::size_t(n - 2)) {
+            std::printf("%10d wrong triangle count\n", n);
+            return 1;
+        }
+        double automatic = measure([&] { return triangulate(star).size(); });
+        double monotone = measure([&] { return triangulateMonotone(star).size(); });
+        if (n <= MAX_EAR_CLIPPING_VERTICES) {
+            double ear = measure([&] { return triangulateEarClipping(star).size(); });
+            std::printf("%10d %16.4f %16.4f %16.4f\n", n, automatic, monotone, ear);
+        } else {
+            std::printf("%10d %16.4f %16.4f %16s\n", n, automatic, monotone, "-");
+        }
+    }
+    return 0;
+}
@@ -32,6 +32,13 @@ linux-clang*|linux-g++*|macx-clang*|macx-g++* {
     QMAKE_CXXFLAGS += -fstack-protector-all
 }
 
+# Stores each node's color in 8 bits per channel rather than three floats.
+# Saves memory in very large scenes: qmake CONFIG+=packed_colors
+packed_colors {
+    message("Packing node colors")
+    DEFINES += SCENEGRAPH_PACKED_COLORS
+}
+
 # FOR LINUX & MAC USERS INTERESTED IN ADDITIONAL BUILD TOOLS
 # ----------------------------------------------------------
 # This conditional exists to enable Address Sanitizer (ASAN) during
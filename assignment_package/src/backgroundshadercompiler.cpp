@@ -0,0 +1,108 @@
+#include "backgroundshadercompiler.h"
+#include "shaderprogram.h"
+
+BackgroundShaderCompiler::BackgroundShaderCompiler(QOpenGLContext* shareWith)
+    : mp_shareWith(shareWith), m_format(shareWith->format()), m_surface(), m_thread(),
+      m_mutex(), m_running(false), m_hasJob(false), m_vertSource(), m_fragSource(),
+      m_hasResult(false), m_result()
+{
+    m_surface.setFormat(m_format);
+    m_surface.create();
+}
+
+BackgroundShaderCompiler::~BackgroundShaderCompiler()
+{
+    // A result nobody took stays in the share group and is freed with it
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+bool BackgroundShaderCompiler::isSupported()
+{
+    return QOpenGLContext::supportsThreadedOpenGL();
+}
+
+void BackgroundShaderCompiler::start(const QByteArray& vertSource, const QByteArray& fragSource)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_vertSource = vertSource;
+    m_fragSource = fragSource;
+    m_hasJob = true;
+    if (!m_running) {
+        // The previous worker has left its loop, so this doesn't wait
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        m_running = true;
+        m_thread = std::thread(&BackgroundShaderCompiler::run, this);
+    }
+}
+
+bool BackgroundShaderCompiler::takeResult(GLuint* prog, GLuint* vertShader, GLuint* fragShader)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_hasResult) {
+        return false;
+    }
+    *prog = m_result.prog;
+    *vertShader = m_result.vertShader;
+    *fragShader = m_result.fragShader;
+    m_hasResult = false;
+    return true;
+}
+
+void BackgroundShaderCompiler::run()
+{
+    // A context of this thread's own, made per burst of jobs since reloads are rare
+    QOpenGLContext context;
+    context.setFormat(m_format);
+    context.setShareContext(mp_shareWith);
+    QOpenGLFunctions_3_2_Core gl;
+    bool ready = context.create() && context.makeCurrent(&m_surface) && gl.initializeOpenGLFunctions();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_hasJob) {
+        QByteArray vertSource = m_vertSource;
+        QByteArray fragSource = m_fragSource;
+        m_hasJob = false;
+        lock.unlock();
+
+        Result result = {0, 0, 0};
+        if (ready) {
+            result.prog = gl.glCreateProgram();
+            ShaderProgram::compileAndLink(gl, vertSource, fragSource, result.prog,
+                                          &result.vertShader, &result.fragShader);
+            // Done compiling and visible to the widget's context before it is handed out
+            gl.glFinish();
+        }
+
+        lock.lock();
+        if (m_hasJob) {
+            // Superseded while it was being built
+            discard(gl, result);
+            continue;
+        }
+        if (m_hasResult) {
+            discard(gl, m_result);
+        }
+        m_result = result;
+        m_hasResult = true;
+    }
+    m_running = false;
+    lock.unlock();
+
+    if (ready) {
+        context.doneCurrent();
+    }
+}
+
+void BackgroundShaderCompiler::discard(QOpenGLFunctions_3_2_Core& gl, const Result& result)
+{
+    // Nothing was made without a context; deleting handle 0 is ignored anyway
+    if (result.prog) {
+        gl.glDeleteProgram(result.prog);
+        gl.glDeleteShader(result.vertShader);
+        gl.glDeleteShader(result.fragShader);
+    }
+}
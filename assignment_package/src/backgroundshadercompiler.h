@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QByteArray>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_2_Core>
+#include <mutex>
+#include <thread>
+
+// Compiles and links shader programs on a worker thread, in an OpenGL context that
+// shares objects with the widget's, so that drivers without KHR_parallel_shader_compile
+// don't stall the GUI thread in glLinkProgram. The finished program is a shared object,
+// so the widget's context can check and use it right away.
+// Jobs are started and results taken on the GUI thread; only the newest job's result is kept.
+class BackgroundShaderCompiler
+{
+public:
+    // Must be called on the GUI thread with shareWith current
+    explicit BackgroundShaderCompiler(QOpenGLContext* shareWith);
+    // Waits for a compile that is still running
+    ~BackgroundShaderCompiler();
+
+    // False if the platform can't use OpenGL contexts on other threads
+    static bool isSupported();
+
+    // Starts building a program from the given sources. Replaces a job that hasn't
+    // finished yet; its program is deleted instead of being handed out.
+    void start(const QByteArray& vertSource, const QByteArray& fragSource);
+    // If the newest job has finished, hands out its program and shaders and returns true.
+    // The link status still has to be checked. All three are 0 if the worker's context
+    // couldn't be created.
+    bool takeResult(GLuint* prog, GLuint* vertShader, GLuint* fragShader);
+
+private:
+    struct Result {
+        GLuint prog;
+        GLuint vertShader;
+        GLuint fragShader;
+    };
+
+    // Body of the worker thread: builds jobs until none is left
+    void run();
+    // Deletes a result nobody took. The worker's context must be current.
+    static void discard(QOpenGLFunctions_3_2_Core& gl, const Result& result);
+
+    QOpenGLContext* mp_shareWith;
+    QSurfaceFormat m_format;
+    QOffscreenSurface m_surface; // Created here, since surfaces must be made on the GUI thread
+    std::thread m_thread;
+
+    std::mutex m_mutex; // Guards everything below
+    bool m_running;     // True while m_thread is working through jobs
+    bool m_hasJob;
+    QByteArray m_vertSource;
+    QByteArray m_fragSource;
+    bool m_hasResult;
+    Result m_result;
+};
@@ -0,0 +1,259 @@
+#include "batchrenderer.h"
+#include <QOpenGLContext>
+#include <cstddef>
+#include <cstring>
+
+// From ARB_draw_indirect, in case the GL headers predate it
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+static_assert(sizeof(BatchRenderer::Instance) == 12 * sizeof(float),
+              "Instance must be tightly packed to be read as vertex attributes");
+static_assert(sizeof(BatchRenderer::DrawCommand) == 5 * sizeof(GLuint),
+              "DrawCommand must match the layout of glMultiDrawElementsIndirect");
+
+// Room for this many instances per section is allocated up front
+const static GLuint INITIAL_CAPACITY = 1024;
+
+BatchRenderer::BatchRenderer(OpenGLContext* context)
+    : m_commands(),
+      m_instanceStream(context, GL_ARRAY_BUFFER), m_commandStream(context, GL_DRAW_INDIRECT_BUFFER),
+      mp_mapped(nullptr), m_sectionInstances(0), m_capacity(0),
+      m_frameCommands(0), m_frameInstances(0), m_frameDrawCalls(0), m_frameUploadBytes(0),
+      m_lastCommands(0), m_lastInstances(0), m_lastDrawCalls(0), m_lastUploadBytes(0),
+      mp_prog(nullptr), mp_geometry(nullptr),
+      m_path(Path::None), m_vertexAttribDivisor(nullptr), m_multiDrawElementsIndirect(nullptr),
+      mp_context(context)
+{}
+
+BatchRenderer::~BatchRenderer()
+{
+    destroy();
+}
+
+void BatchRenderer::create()
+{
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    if (!ctx) {
+        return;
+    }
+    QSurfaceFormat form = ctx->format();
+    auto atLeast = [&form](int major, int minor) {
+        return form.majorVersion() > major || (form.majorVersion() == major && form.minorVersion() >= minor);
+    };
+
+    if (atLeast(3, 3)) {
+        m_vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorFn>(ctx->getProcAddress("glVertexAttribDivisor"));
+    } else if (ctx->hasExtension("GL_ARB_instanced_arrays")) {
+        m_vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorFn>(ctx->getProcAddress("glVertexAttribDivisorARB"));
+    }
+    // Non-zero baseInstance needs 4.2 / ARB_base_instance on top of the indirect draw itself
+    if (atLeast(4, 3) || (ctx->hasExtension("GL_ARB_multi_draw_indirect")
+                          && (atLeast(4, 2) || ctx->hasExtension("GL_ARB_base_instance")))) {
+        m_multiDrawElementsIndirect = reinterpret_cast<MultiDrawElementsIndirectFn>(
+                    ctx->getProcAddress("glMultiDrawElementsIndirect"));
+    }
+
+    if (!m_vertexAttribDivisor) {
+        m_path = Path::None;
+    } else if (m_multiDrawElementsIndirect) {
+        m_path = Path::MultiDrawIndirect;
+    } else {
+        m_path = Path::Instanced;
+    }
+    if (m_path != Path::None) {
+        allocate(INITIAL_CAPACITY);
+    }
+}
+
+void BatchRenderer::destroy()
+{
+    m_instanceStream.destroy();
+    m_commandStream.destroy();
+    m_capacity = 0;
+    m_path = Path::None;
+}
+
+void BatchRenderer::allocate(GLuint capacity)
+{
+    m_capacity = capacity;
+    m_instanceStream.create(capacity * sizeof(Instance));
+    if (m_path == Path::MultiDrawIndirect) {
+        // A section never holds more commands than instances
+        m_commandStream.create(capacity * sizeof(DrawCommand));
+    }
+}
+
+BatchRenderer::Path BatchRenderer::path() const
+{
+    return m_path;
+}
+
+bool BatchRenderer::isSupported() const
+{
+    return m_path != Path::None;
+}
+
+void BatchRenderer::begin(ShaderProgram& prog, GeometryBuffer& buffer)
+{
+    mp_prog = &prog;
+    mp_geometry = &buffer;
+
+    // Last frame didn't fit into one section; make the next one fit
+    if (m_lastInstances > m_capacity) {
+        GLuint capacity = m_capacity;
+        while (capacity < m_lastInstances) {
+            capacity *= 2;
+        }
+        allocate(capacity);
+    }
+
+    m_frameCommands = 0;
+    m_frameInstances = 0;
+    m_frameDrawCalls = 0;
+    m_frameUploadBytes = 0;
+    mapSection();
+}
+
+void BatchRenderer::mapSection()
+{
+    mp_mapped = static_cast<Instance*>(m_instanceStream.map());
+    m_sectionInstances = 0;
+    // clear() keeps the capacity, so steady frames don't reallocate
+    m_commands.clear();
+}
+
+void BatchRenderer::add(Drawable& d, const glm::mat3& model, const glm::vec3& color)
+{
+    if (m_sectionInstances == m_capacity) {
+        drawSection();
+        mapSection();
+    }
+    GLuint instance = m_sectionInstances++;
+    mp_mapped[instance] = {model, color};
+    m_frameInstances++;
+
+    if (!m_commands.empty()) {
+        DrawCommand& last = m_commands.back();
+        if (last.firstIndex == d.firstIndex() && last.baseVertex == d.baseVertex()
+                && last.count == GLuint(d.elemCount())) {
+            // Same geometry as the previous draw: one more instance of it
+            last.instanceCount++;
+            return;
+        }
+    }
+    m_commands.push_back({GLuint(d.elemCount()), 1, d.firstIndex(), d.baseVertex(), instance});
+}
+
+void BatchRenderer::end()
+{
+    drawSection();
+    m_lastCommands = m_frameCommands;
+    m_lastInstances = m_frameInstances;
+    m_lastDrawCalls = m_frameDrawCalls;
+    m_lastUploadBytes = m_frameUploadBytes;
+}
+
+void BatchRenderer::setInstanceAttributes(GLuint firstInstance, GLuint divisor)
+{
+    ShaderProgram& prog = *mp_prog;
+    const char* base = reinterpret_cast<const char*>(m_instanceStream.offset() + firstInstance * sizeof(Instance));
+    if (prog.m_attrModel != -1) {
+        // A mat3 attribute takes three consecutive locations, one per column
+        for (int col = 0; col < 3; col++) {
+            mp_context->glVertexAttribPointer(prog.m_attrModel + col, 3, GL_FLOAT, false, sizeof(Instance),
+                                              base + offsetof(Instance, model) + col * sizeof(glm::vec3));
+            m_vertexAttribDivisor(prog.m_attrModel + col, divisor);
+        }
+    }
+    if (prog.m_attrCol != -1) {
+        mp_context->glVertexAttribPointer(prog.m_attrCol, 3, GL_FLOAT, false, sizeof(Instance),
+                                          base + offsetof(Instance, color));
+        m_vertexAttribDivisor(prog.m_attrCol, divisor);
+    }
+}
+
+void BatchRenderer::drawSection()
+{
+    m_instanceStream.unmap();
+    mp_mapped = nullptr;
+    if (m_commands.empty()) {
+        return;
+    }
+    m_frameCommands += m_commands.size();
+    m_frameUploadBytes += m_sectionInstances * sizeof(Instance);
+
+    ShaderProgram& prog = *mp_prog;
+    prog.useMe();
+
+    if (prog.m_attrPos != -1 && mp_geometry->bindPos()) {
+        mp_context->glEnableVertexAttribArray(prog.m_attrPos);
+        mp_context->glVertexAttribPointer(prog.m_attrPos, 3, GL_FLOAT, false, 0, NULL);
+    }
+    mp_geometry->bindIdx();
+
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_instanceStream.buffer());
+    if (prog.m_attrModel != -1) {
+        for (int col = 0; col < 3; col++) {
+            mp_context->glEnableVertexAttribArray(prog.m_attrModel + col);
+        }
+    }
+    if (prog.m_attrCol != -1) mp_context->glEnableVertexAttribArray(prog.m_attrCol);
+
+    if (m_path == Path::MultiDrawIndirect) {
+        setInstanceAttributes(0, 1);
+        void* commands = m_commandStream.map();
+        std::memcpy(commands, m_commands.data(), m_commands.size() * sizeof(DrawCommand));
+        m_commandStream.unmap();
+        mp_context->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandStream.buffer());
+        m_multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    reinterpret_cast<const void*>(m_commandStream.offset()), m_commands.size(), 0);
+        mp_context->glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        m_commandStream.fence();
+        m_frameDrawCalls++;
+        m_frameUploadBytes += m_commands.size() * sizeof(DrawCommand);
+    } else {
+        // Without baseInstance, each command re-points the instance attributes at its own range
+        for (const DrawCommand& cmd : m_commands) {
+            setInstanceAttributes(cmd.baseInstance, 1);
+            mp_context->glDrawElementsInstancedBaseVertex(GL_TRIANGLES, cmd.count, GL_UNSIGNED_INT,
+                                                          reinterpret_cast<void*>(cmd.firstIndex * sizeof(GLuint)),
+                                                          cmd.instanceCount, cmd.baseVertex);
+        }
+        m_frameDrawCalls += m_commands.size();
+    }
+    m_instanceStream.fence();
+
+    // The divisors are part of the VAO, which the non-batched draws share
+    setInstanceAttributes(0, 0);
+    if (prog.m_attrModel != -1) {
+        for (int col = 0; col < 3; col++) {
+            mp_context->glDisableVertexAttribArray(prog.m_attrModel + col);
+        }
+    }
+    if (prog.m_attrCol != -1) mp_context->glDisableVertexAttribArray(prog.m_attrCol);
+    if (prog.m_attrPos != -1) mp_context->glDisableVertexAttribArray(prog.m_attrPos);
+
+    mp_context->printGLErrorLog();
+}
+
+std::size_t BatchRenderer::commandCount() const
+{
+    return m_lastCommands;
+}
+
+std::size_t BatchRenderer::instanceCount() const
+{
+    return m_lastInstances;
+}
+
+std::size_t BatchRenderer::drawCallCount() const
+{
+    return m_lastDrawCalls;
+}
+
+std::size_t BatchRenderer::uploadedBytes() const
+{
+    return m_lastUploadBytes;
+}
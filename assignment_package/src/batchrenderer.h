@@ -0,0 +1,109 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <la.h>
+#include <vector>
+#include "drawable.h"
+#include "geometrybuffer.h"
+#include "shaderprogram.h"
+#include "streambuffer.h"
+
+// Collects the polygons a scene graph traversal wants drawn, then submits them
+// all at once. Consecutive draws of the same geometry become one instanced
+// command; every node's model matrix and color are per-instance attributes.
+// With OpenGL 4.3 (or ARB_multi_draw_indirect + ARB_base_instance) the whole
+// command list is one glMultiDrawElementsIndirect call, so submitting a frame
+// costs the same number of GL calls however large the scene is.
+// With OpenGL 3.3 (or ARB_instanced_arrays) each command is its own
+// glDrawElementsInstancedBaseVertex call.
+// Instances are streamed through a persistently mapped ring buffer (see
+// StreamBuffer). A frame with more instances than one section holds is drawn
+// in several submissions, and the sections grow to fit it the next frame.
+class BatchRenderer
+{
+public:
+    // The layout glMultiDrawElementsIndirect reads commands in
+    struct DrawCommand {
+        GLuint count;         // Number of indices
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;  // First entry of the instance buffer used by this command
+    };
+
+    // Per-instance data, read by the shader as vs_Model and vs_Col
+    struct Instance {
+        glm::mat3 model;
+        glm::vec3 color;
+    };
+
+    enum class Path { None, Instanced, MultiDrawIndirect };
+
+    BatchRenderer(OpenGLContext* context);
+    ~BatchRenderer();
+
+    // Picks the submission path the driver supports and creates the GPU buffers.
+    // The context must be current.
+    void create();
+    void destroy();
+
+    // The path create() picked. With Path::None nothing can be batched, and
+    // callers should draw every Drawable on its own instead.
+    Path path() const;
+    bool isSupported() const;
+
+    // Starts a frame whose draws use prog and the geometry in buffer
+    void begin(ShaderProgram& prog, GeometryBuffer& buffer);
+    // Queues d, which must live in the GeometryBuffer passed to begin() and be
+    // drawn as GL_TRIANGLES, with the given transformation and color.
+    // The instance is written straight into mapped GPU memory.
+    void add(Drawable& d, const glm::mat3& model, const glm::vec3& color);
+    // Issues the draws queued since begin(), in the order they were added
+    void end();
+
+    // Size of the last frame
+    std::size_t commandCount() const;
+    std::size_t instanceCount() const;
+    // GL draw calls the last frame took, and bytes of instances and commands it streamed to the GPU
+    std::size_t drawCallCount() const;
+    std::size_t uploadedBytes() const;
+
+private:
+    typedef void (QOPENGLF_APIENTRYP VertexAttribDivisorFn)(GLuint, GLuint);
+    typedef void (QOPENGLF_APIENTRYP MultiDrawElementsIndirectFn)(GLenum, GLenum, const void*, GLsizei, GLsizei);
+
+    // (Re)creates the streams with room for capacity instances per section
+    void allocate(GLuint capacity);
+    // Maps the next section of the instance stream for add() to write into
+    void mapSection();
+    // Unmaps the current section and issues its draws
+    void drawSection();
+    // Points the per-instance attributes at the instance stream, starting from firstInstance of the current section
+    void setInstanceAttributes(GLuint firstInstance, GLuint divisor);
+
+    std::vector<DrawCommand> m_commands; // Commands of the current section; small, so built on the CPU
+
+    StreamBuffer m_instanceStream; // Instances, written by add() through mp_mapped
+    StreamBuffer m_commandStream;  // Copies of m_commands for glMultiDrawElementsIndirect
+    Instance* mp_mapped;           // Where the current section of m_instanceStream is mapped
+    GLuint m_sectionInstances;     // Instances written into the current section
+    GLuint m_capacity;             // Instances that fit into one section
+
+    std::size_t m_frameCommands;   // Totals of the frame in progress
+    std::size_t m_frameInstances;
+    std::size_t m_frameDrawCalls;
+    std::size_t m_frameUploadBytes;
+    std::size_t m_lastCommands;    // Totals of the last finished frame
+    std::size_t m_lastInstances;
+    std::size_t m_lastDrawCalls;
+    std::size_t m_lastUploadBytes;
+
+    ShaderProgram* mp_prog;        // What the frame in progress draws with
+    GeometryBuffer* mp_geometry;
+
+    Path m_path;
+    VertexAttribDivisorFn m_vertexAttribDivisor;
+    MultiDrawElementsIndirectFn m_multiDrawElementsIndirect;
+
+    OpenGLContext* mp_context;
+};
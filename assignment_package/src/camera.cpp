@@ -0,0 +1,103 @@
+#include "camera.h"
+#include <algorithm>
+
+// Scene units between the center and the top edge of the initial view
+const static float DEFAULT_HALF_HEIGHT = 5.f;
+// Limits on zooming, so the view matrix stays well conditioned
+const static float MIN_HALF_HEIGHT = 1e-4f;
+const static float MAX_HALF_HEIGHT = 1e6f;
+// frame() leaves this fraction of the view empty around the box
+const static float FRAME_MARGIN = 0.05f;
+
+Camera::Camera()
+    : m_center(0.f), m_halfHeight(DEFAULT_HALF_HEIGHT), m_viewport(1.f),
+      m_view(1.f), m_viewDirty(true), m_changed(true)
+{}
+
+void Camera::setViewport(int width, int height)
+{
+    m_viewport = glm::vec2(std::max(width, 1), std::max(height, 1));
+    markChanged();
+}
+
+void Camera::pan(const glm::vec2& pixelDelta)
+{
+    // Pixels to scene units; y points down on screen and up in the scene
+    glm::vec2 unitsPerPixel = 2.f * halfExtent() / m_viewport;
+    m_center -= glm::vec2(pixelDelta.x, -pixelDelta.y) * unitsPerPixel;
+    markChanged();
+}
+
+void Camera::zoomAt(float factor, const glm::vec2& pixel)
+{
+    glm::vec2 anchor = pixelToScene(pixel);
+    m_halfHeight = std::min(MAX_HALF_HEIGHT, std::max(MIN_HALF_HEIGHT, m_halfHeight / factor));
+    // Move the center so that anchor is back under the same pixel
+    m_center += anchor - pixelToScene(pixel);
+    markChanged();
+}
+
+void Camera::reset()
+{
+    m_center = glm::vec2(0.f);
+    m_halfHeight = DEFAULT_HALF_HEIGHT;
+    markChanged();
+}
+
+void Camera::frame(const glm::vec2& min, const glm::vec2& max)
+{
+    glm::vec2 halfSize = 0.5f * (max - min);
+    m_center = 0.5f * (min + max);
+    // Whichever of the box's width and height is the tighter fit decides the zoom
+    float halfHeight = std::max(halfSize.y, halfSize.x * m_viewport.y / m_viewport.x) * (1.f + FRAME_MARGIN);
+    m_halfHeight = std::min(MAX_HALF_HEIGHT, std::max(MIN_HALF_HEIGHT, halfHeight));
+    markChanged();
+}
+
+const glm::mat3& Camera::viewMatrix() const
+{
+    if (m_viewDirty) {
+        m_view = glm::scale(glm::mat3(), 1.f / halfExtent()) * glm::translate(glm::mat3(), -m_center);
+        m_viewDirty = false;
+    }
+    return m_view;
+}
+
+glm::vec2 Camera::pixelToScene(const glm::vec2& pixel) const
+{
+    glm::vec2 ndc(2.f * pixel.x / m_viewport.x - 1.f, 1.f - 2.f * pixel.y / m_viewport.y);
+    return m_center + ndc * halfExtent();
+}
+
+glm::vec2 Camera::visibleMin() const
+{
+    return m_center - halfExtent();
+}
+
+glm::vec2 Camera::visibleMax() const
+{
+    return m_center + halfExtent();
+}
+
+glm::vec2 Camera::viewportSize() const
+{
+    return m_viewport;
+}
+
+bool Camera::takeChanged()
+{
+    bool changed = m_changed;
+    m_changed = false;
+    return changed;
+}
+
+glm::vec2 Camera::halfExtent() const
+{
+    return glm::vec2(m_halfHeight * m_viewport.x / m_viewport.y, m_halfHeight);
+}
+
+void Camera::markChanged()
+{
+    m_viewDirty = true;
+    m_changed = true;
+}
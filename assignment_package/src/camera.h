@@ -0,0 +1,49 @@
+#pragma once
+
+#include <la.h>
+
+// A 2D camera looking at the scene from above: which point is in the middle
+// of the widget, and how many scene units fit between its center and its top edge.
+// The horizontal extent follows the widget's aspect ratio, so shapes aren't stretched.
+// The view matrix is only recomputed after something changed.
+class Camera
+{
+public:
+    Camera();
+
+    // Must be called whenever the widget is resized
+    void setViewport(int width, int height);
+    // Moves the scene along with a mouse drag of the given number of pixels
+    void pan(const glm::vec2& pixelDelta);
+    // Zooms in by factor (zooms out if it's below 1), keeping the scene point under the given pixel in place
+    void zoomAt(float factor, const glm::vec2& pixel);
+    // Back to the initial view of -5..5 vertically around the origin
+    void reset();
+    // Centers the view on the box from min to max and zooms so that it just fits
+    void frame(const glm::vec2& min, const glm::vec2& max);
+
+    // Maps scene coordinates to normalized device coordinates
+    const glm::mat3& viewMatrix() const;
+    // The scene point drawn at the given widget pixel (y pointing down)
+    glm::vec2 pixelToScene(const glm::vec2& pixel) const;
+    // Corners of the part of the scene that is visible
+    glm::vec2 visibleMin() const;
+    glm::vec2 visibleMax() const;
+    glm::vec2 viewportSize() const;
+
+    // Returns true once after every change, so the view matrix is uploaded only when needed
+    bool takeChanged();
+
+private:
+    // Half the size of the visible part of the scene
+    glm::vec2 halfExtent() const;
+    void markChanged();
+
+    glm::vec2 m_center;
+    float m_halfHeight;
+    glm::vec2 m_viewport;
+
+    mutable glm::mat3 m_view;
+    mutable bool m_viewDirty; // m_view needs recomputing
+    bool m_changed;           // Something changed since the last takeChanged()
+};
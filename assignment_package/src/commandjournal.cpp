@@ -0,0 +1,285 @@
+#include "commandjournal.h"
+#include "memoryreport.h"
+#include <algorithm>
+
+// Bytes of nodes that undone AddChild entries may keep alive by default
+const static std::size_t DEFAULT_DETACHED_CAPACITY = std::size_t(256) << 20;
+
+CommandJournal::CommandJournal(std::size_t capacity, SceneChangeLog* changeLog)
+    : m_undo(), m_redo(), m_capacity(capacity), m_detachedCapacity(DEFAULT_DETACHED_CAPACITY), m_detachedBytes(0),
+      mp_changeLog(changeLog), m_canMerge(false)
+{}
+
+void CommandJournal::recordParam(Node* node, Param param, float before, float after)
+{
+    if (before == after) {
+        return;
+    }
+    if (m_canMerge && !m_undo.empty()) {
+        Command& last = m_undo.back();
+        if (last.kind == Kind::Param && last.node == node && last.param == param) {
+            // Still the same interaction: only the end value changes
+            last.value.after = after;
+            return;
+        }
+    }
+
+    Command cmd;
+    cmd.kind = Kind::Param;
+    cmd.param = param;
+    cmd.node = node;
+    cmd.value = {before, after};
+    push(std::move(cmd));
+
+    m_canMerge = true;
+}
+
+void CommandJournal::recordParams(Param param, std::vector<ParamChange> changes)
+{
+    changes.erase(std::remove_if(changes.begin(), changes.end(),
+                                 [](const ParamChange& c) { return c.before == c.after; }),
+                  changes.end());
+    if (changes.empty()) {
+        return;
+    }
+    if (changes.size() == 1) {
+        recordParam(changes[0].node, param, changes[0].before, changes[0].after);
+        return;
+    }
+
+    if (m_canMerge && !m_undo.empty()) {
+        Command& last = m_undo.back();
+        bool sameNodes = last.kind == Kind::BulkParam && last.param == param
+                && last.changes.size() == changes.size();
+        for (std::size_t i = 0; sameNodes && i < changes.size(); i++) {
+            sameNodes = last.changes[i].node == changes[i].node;
+        }
+        if (sameNodes) {
+            for (std::size_t i = 0; i < changes.size(); i++) {
+                last.changes[i].after = changes[i].after;
+            }
+            return;
+        }
+    }
+
+    Command cmd;
+    cmd.kind = Kind::BulkParam;
+    cmd.param = param;
+    cmd.node = nullptr;
+    cmd.child = nullptr;
+    cmd.changes = std::move(changes);
+    push(std::move(cmd));
+
+    m_canMerge = true;
+}
+
+void CommandJournal::recordGeometry(Node* node, Polygon2D* before, Polygon2D* after)
+{
+    if (before == after) {
+        return;
+    }
+    Command cmd;
+    cmd.kind = Kind::Geometry;
+    cmd.param = Param::TX;
+    cmd.node = node;
+    cmd.child = nullptr;
+    cmd.geometryBefore = before;
+    cmd.geometryAfter = after;
+    push(std::move(cmd));
+    m_canMerge = false;
+}
+
+void CommandJournal::recordAddChild(Node* parent, Node* child)
+{
+    Command cmd;
+    cmd.kind = Kind::AddChild;
+    cmd.param = Param::TX;
+    cmd.node = parent;
+    cmd.child = child;
+    push(std::move(cmd));
+    m_canMerge = false;
+}
+
+void CommandJournal::endInteraction()
+{
+    m_canMerge = false;
+}
+
+void CommandJournal::push(Command cmd)
+{
+    // A new edit makes everything that was undone unreachable. This also
+    // frees any subtrees that were detached by undoing an AddChild.
+    m_redo.clear();
+    m_detachedBytes = 0;
+
+    m_undo.push_back(std::move(cmd));
+    while (m_undo.size() > m_capacity) {
+        m_undo.pop_front();
+    }
+}
+
+bool CommandJournal::undo()
+{
+    if (m_undo.empty()) {
+        return false;
+    }
+    Command cmd = std::move(m_undo.back());
+    m_undo.pop_back();
+
+    switch (cmd.kind) {
+    case Kind::Param:
+        applyParam(cmd.node, cmd.param, cmd.value.before);
+        break;
+    case Kind::BulkParam:
+        for (const ParamChange& c : cmd.changes) {
+            applyParam(c.node, cmd.param, c.before);
+        }
+        break;
+    case Kind::Geometry:
+        cmd.node->setGeometry(cmd.geometryBefore.get());
+        break;
+    case Kind::AddChild:
+        cmd.detached = cmd.node->removeChild(cmd.child, mp_changeLog);
+        if (cmd.detached) {
+            MemoryReport report;
+            report.addScene(*cmd.detached);
+            cmd.detachedBytes = report.nodeBytes + report.childrenBytes;
+            m_detachedBytes += cmd.detachedBytes;
+        }
+        break;
+    }
+
+    m_redo.push_back(std::move(cmd));
+    m_canMerge = false;
+    trimDetached();
+    return true;
+}
+
+bool CommandJournal::redo()
+{
+    if (m_redo.empty()) {
+        return false;
+    }
+    Command cmd = std::move(m_redo.back());
+    m_redo.pop_back();
+
+    switch (cmd.kind) {
+    case Kind::Param:
+        applyParam(cmd.node, cmd.param, cmd.value.after);
+        break;
+    case Kind::BulkParam:
+        for (const ParamChange& c : cmd.changes) {
+            applyParam(c.node, cmd.param, c.after);
+        }
+        break;
+    case Kind::Geometry:
+        cmd.node->setGeometry(cmd.geometryAfter.get());
+        break;
+    case Kind::AddChild:
+        cmd.node->addChild(std::move(cmd.detached), mp_changeLog);
+        m_detachedBytes -= cmd.detachedBytes;
+        cmd.detachedBytes = 0;
+        break;
+    }
+
+    m_undo.push_back(std::move(cmd));
+    m_canMerge = false;
+    return true;
+}
+
+bool CommandJournal::canUndo() const
+{
+    return !m_undo.empty();
+}
+
+bool CommandJournal::canRedo() const
+{
+    return !m_redo.empty();
+}
+
+void CommandJournal::setCapacity(std::size_t capacity)
+{
+    m_capacity = capacity;
+    while (m_undo.size() > m_capacity) {
+        m_undo.pop_front();
+    }
+}
+
+std::size_t CommandJournal::capacity() const
+{
+    return m_capacity;
+}
+
+void CommandJournal::setDetachedCapacity(std::size_t bytes)
+{
+    m_detachedCapacity = bytes;
+    trimDetached();
+}
+
+std::size_t CommandJournal::detachedCapacity() const
+{
+    return m_detachedCapacity;
+}
+
+std::size_t CommandJournal::detachedBytes() const
+{
+    return m_detachedBytes;
+}
+
+void CommandJournal::clear()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_detachedBytes = 0;
+    m_canMerge = false;
+}
+
+void CommandJournal::trimDetached()
+{
+    // The front of m_redo would be redone last, so it is the least likely to be wanted
+    std::size_t dropped = 0;
+    while (m_detachedBytes > m_detachedCapacity && dropped < m_redo.size()) {
+        m_detachedBytes -= m_redo[dropped].detachedBytes;
+        dropped++;
+    }
+    m_redo.erase(m_redo.begin(), m_redo.begin() + dropped);
+}
+
+void CommandJournal::applyParam(Node* node, Param param, float value)
+{
+    // The node was already checked to be of the right type when the edit was recorded
+    switch (param) {
+    case Param::TX:
+        static_cast<TranslateNode*>(node)->setTX(value);
+        break;
+    case Param::TY:
+        static_cast<TranslateNode*>(node)->setTY(value);
+        break;
+    case Param::Rotate:
+        static_cast<RotateNode*>(node)->setRotate(value);
+        break;
+    case Param::SX:
+        static_cast<ScaleNode*>(node)->setSX(value);
+        break;
+    case Param::SY:
+        static_cast<ScaleNode*>(node)->setSY(value);
+        break;
+    }
+}
+
+float CommandJournal::readParam(const Node* node, Param param)
+{
+    switch (param) {
+    case Param::TX:
+        return static_cast<const TranslateNode*>(node)->getTX();
+    case Param::TY:
+        return static_cast<const TranslateNode*>(node)->getTY();
+    case Param::Rotate:
+        return static_cast<const RotateNode*>(node)->getRotate();
+    case Param::SX:
+        return static_cast<const ScaleNode*>(node)->getSX();
+    case Param::SY:
+        return static_cast<const ScaleNode*>(node)->getSY();
+    }
+    return 0.f;
+}
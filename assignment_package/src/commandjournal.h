@@ -0,0 +1,108 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <smartpointerhelp.h>
+#include "scene/node.h"
+
+// Records the edits made to the scene graph so they can be undone and redone.
+// Every entry stores only what changed: one transformation parameter's old
+// and new value, a node's old and new geometry, or one attached child.
+// History is bounded by entry count and by the bytes of the subtrees that undone
+// AddChild entries keep alive, since one of those can be a copy of a huge scene.
+class CommandJournal
+{
+public:
+    // The transformation parameters that can be edited from the GUI
+    enum class Param : unsigned char { TX, TY, Rotate, SX, SY };
+
+    // One node's part of an edit applied to many nodes at once
+    struct ParamChange {
+        Node* node;
+        float before;
+        float after;
+    };
+
+    // Keeps at most capacity undoable entries; the oldest ones are dropped first.
+    // Nodes that undo / redo attach or detach are reported to changeLog, if given.
+    explicit CommandJournal(std::size_t capacity = 1000, SceneChangeLog* changeLog = nullptr);
+
+    // Records param of node changing from before to after.
+    // Consecutive edits of the same parameter within one interaction
+    // (e.g. while stepping or typing in a spin box) are merged into a single entry.
+    void recordParam(Node* node, Param param, float before, float after);
+    // Records param changing on many nodes at once as a single entry.
+    // Merged with the previous entry like recordParam if that edited the same nodes.
+    void recordParams(Param param, std::vector<ParamChange> changes);
+    // Records node's geometry changing from before to after
+    void recordGeometry(Node* node, Polygon2D* before, Polygon2D* after);
+    // Records child having just been added to parent with Node::addChild
+    void recordAddChild(Node* parent, Node* child);
+    // Ends the current interaction, e.g. when a spin box finishes editing or a slider is
+    // released: the next parameter edit starts a new entry instead of merging
+    void endInteraction();
+
+    // Reverts the most recent entry. Returns false if there was nothing to undo.
+    bool undo();
+    // Re-applies the most recently undone entry. Returns false if there was nothing to redo.
+    bool redo();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    // Changes the maximum number of undoable entries, dropping the oldest if needed
+    void setCapacity(std::size_t capacity);
+    std::size_t capacity() const;
+    // Changes how many bytes of nodes the subtrees detached by undo may hold. When they
+    // hold more, the redo entries furthest from the present are dropped.
+    void setDetachedCapacity(std::size_t bytes);
+    std::size_t detachedCapacity() const;
+    // Bytes of the nodes the journal currently keeps alive for redo
+    std::size_t detachedBytes() const;
+
+    // Forgets all history
+    void clear();
+
+    // Writes value into the given parameter of node, which must be of the matching node type
+    static void applyParam(Node* node, Param param, float value);
+    // Reads the given parameter of node, which must be of the matching node type
+    static float readParam(const Node* node, Param param);
+
+private:
+    enum class Kind : unsigned char { Param, BulkParam, Geometry, AddChild };
+
+    struct ValueDelta {
+        float before;
+        float after;
+    };
+
+    struct Command {
+        Kind kind;
+        Param param;      // Only meaningful for Kind::Param and Kind::BulkParam
+        Node* node;       // The edited node, or the parent for Kind::AddChild
+        union {
+            ValueDelta value;       // Kind::Param
+            Node* child;            // Kind::AddChild
+        };
+        // Kind::Geometry. Holding references keeps both polygons alive while the entry exists.
+        GeometryRef geometryBefore;
+        GeometryRef geometryAfter;
+        std::vector<ParamChange> changes; // Kind::BulkParam
+        uPtr<Node> detached; // Owns the child of an AddChild while it is undone
+        std::size_t detachedBytes = 0; // Bytes of the nodes in detached
+    };
+
+    // Appends cmd to the undo history, discarding the redo history
+    void push(Command cmd);
+    // Drops redo entries, oldest first, until the detached subtrees fit m_detachedCapacity
+    void trimDetached();
+
+    std::deque<Command> m_undo;
+    std::vector<Command> m_redo;
+    std::size_t m_capacity;
+    std::size_t m_detachedCapacity;
+    std::size_t m_detachedBytes; // Sum of detachedBytes over m_redo
+    SceneChangeLog* mp_changeLog;
+
+    bool m_canMerge; // False once the interaction ends or anything but a parameter edit happens
+};
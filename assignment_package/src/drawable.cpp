@@ -4,6 +4,7 @@
 Drawable::Drawable(OpenGLContext* context)
     : m_count(-1), m_bufIdx(), m_bufPos(), m_bufCol(),
       m_idxBound(false), m_posBound(false), m_colBound(false),
+      mp_sharedBuffer(nullptr), m_sharedRange(),
       mp_context(context)
 {}
 
@@ -15,9 +16,16 @@ Drawable::~Drawable()
 
 void Drawable::destroy()
 {
-    mp_context->glDeleteBuffers(1, &m_bufIdx);
-    mp_context->glDeleteBuffers(1, &m_bufPos);
-    mp_context->glDeleteBuffers(1, &m_bufCol);
+    // Geometry made for a CPU renderer has no context and never had buffers
+    if (mp_context) {
+        mp_context->glDeleteBuffers(1, &m_bufIdx);
+        mp_context->glDeleteBuffers(1, &m_bufPos);
+        mp_context->glDeleteBuffers(1, &m_bufCol);
+    }
+    if (mp_sharedBuffer) {
+        mp_sharedBuffer->free(m_sharedRange);
+        mp_sharedBuffer = nullptr;
+    }
 }
 
 GLenum Drawable::drawMode()
@@ -36,6 +44,48 @@ int Drawable::elemCount()
     return m_count;
 }
 
+GLint Drawable::baseVertex() const
+{
+    return mp_sharedBuffer ? m_sharedRange.baseVertex : 0;
+}
+
+GLuint Drawable::firstIndex() const
+{
+    return mp_sharedBuffer ? m_sharedRange.firstIndex : 0;
+}
+
+GeometryBuffer* Drawable::sharedBuffer() const
+{
+    return mp_sharedBuffer;
+}
+
+std::size_t Drawable::gpuBytes() const
+{
+    std::size_t bytes = 0;
+    if (mp_sharedBuffer) {
+        bytes += m_sharedRange.vertexCount * sizeof(glm::vec3) + m_sharedRange.indexCount * sizeof(GLuint);
+    }
+    if (!mp_context) {
+        return bytes;
+    }
+    // Shared geometry marks its indices and positions bound without buffers of its own
+    bool ownIdx = m_idxBound && !mp_sharedBuffer;
+    bool ownPos = m_posBound && !mp_sharedBuffer;
+    for (GLuint buffer : {ownIdx ? m_bufIdx : 0u, ownPos ? m_bufPos : 0u, m_colBound ? m_bufCol : 0u}) {
+        if (!buffer) {
+            continue;
+        }
+        // GL 3.2 only tells the size of a bound buffer. This target leaves
+        // the vertex array's bindings alone.
+        GLint size = 0;
+        mp_context->glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        mp_context->glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+        bytes += std::size_t(size);
+    }
+    mp_context->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return bytes;
+}
+
 void Drawable::generateIdx()
 {
     m_idxBound = true;
@@ -59,6 +109,10 @@ void Drawable::generateCol()
 
 bool Drawable::bindIdx()
 {
+    if (mp_sharedBuffer)
+    {
+        return mp_sharedBuffer->bindIdx();
+    }
     if (m_idxBound)
     {
         mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufIdx);
@@ -68,6 +122,10 @@ bool Drawable::bindIdx()
 
 bool Drawable::bindPos()
 {
+    if (mp_sharedBuffer)
+    {
+        return mp_sharedBuffer->bindPos();
+    }
     if (m_posBound)
     {
         mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPos);
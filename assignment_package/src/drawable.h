@@ -2,6 +2,7 @@
 
 #include <openglcontext.h>
 #include <la.h>
+#include "geometrybuffer.h"
 
 //This defines a class which can be rendered by our shader program.
 //Make any geometry a subclass of ShaderProgram::Drawable in order to render it with the ShaderProgram class.
@@ -18,21 +19,33 @@ protected:
     bool m_posBound;
     bool m_colBound;
 
+    GeometryBuffer* mp_sharedBuffer; // If set, the positions and indices live in this buffer instead of bufPos / bufIdx
+    GeometryBuffer::Range m_sharedRange; // Where they live in mp_sharedBuffer
+
     OpenGLContext* mp_context; // Since Qt's OpenGL support is done through classes like QOpenGLFunctions_3_2_Core,
                           // we need to pass our OpenGL context to the Drawable in order to call GL functions
                           // from within this class.
 
 
 public:
+    // context may be nullptr for geometry that is only drawn by a CPU RenderBackend
     Drawable(OpenGLContext* context);
     virtual ~Drawable();
 
     virtual void create() = 0; // To be implemented by subclasses. Populates the VBOs of the Drawable.
-    void destroy(); // Frees the VBOs of the Drawable.
+    void destroy(); // Frees the VBOs of the Drawable, or its range of the shared buffer.
 
     // Getter functions for various GL data
     virtual GLenum drawMode();
     int elemCount();
+    // Offsets to pass to glDrawElementsBaseVertex. Both are 0 unless the Drawable lives in a GeometryBuffer.
+    GLint baseVertex() const;
+    GLuint firstIndex() const;
+    // The shared buffer holding this Drawable's positions and indices, or nullptr if it has its own
+    GeometryBuffer* sharedBuffer() const;
+    // GPU memory holding this Drawable: the size of its own buffers plus its range of the shared buffer.
+    // Must be called with the context current; binds GL_COPY_READ_BUFFER to read the sizes.
+    std::size_t gpuBytes() const;
 
     // Call these functions when you want to call glGenBuffers on the buffers stored in the Drawable
     // These will properly set the values of idxBound etc. which need to be checked in ShaderProgram::draw()
@@ -40,6 +53,7 @@ public:
     void generatePos();
     void generateCol();
 
+    // bindIdx and bindPos bind the shared buffers if the Drawable lives in one
     bool bindIdx();
     bool bindPos();
     bool bindCol();
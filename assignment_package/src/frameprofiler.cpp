@@ -0,0 +1,240 @@
+#include "frameprofiler.h"
+#include <QOpenGLContext>
+#include <QSaveFile>
+#include <algorithm>
+
+// From ARB_timer_query, in case the GL headers predate it
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+
+// Frames kept for averages and traces; about four seconds at 60 frames per second
+const static std::size_t FRAME_HISTORY = 240;
+
+FrameProfiler::Zone::Zone(FrameProfiler& profiler, const char* name, bool gpu)
+    : m_profiler(profiler), m_event(profiler.beginZone(name, gpu))
+{}
+
+FrameProfiler::Zone::~Zone()
+{
+    m_profiler.endZone(m_event);
+}
+
+FrameProfiler::FrameProfiler(OpenGLContext* context)
+    : m_clock(), m_frames(), m_frameNumber(0), m_inFrame(false),
+      m_pending(), m_freeQueries(), m_gpuZoneOpen(false),
+      m_getQueryObjectui64v(nullptr), mp_context(context)
+{
+    m_clock.start();
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    destroy();
+}
+
+void FrameProfiler::create()
+{
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    if (!ctx) {
+        return;
+    }
+    QSurfaceFormat form = ctx->format();
+    bool core = form.majorVersion() > 3 || (form.majorVersion() == 3 && form.minorVersion() >= 3);
+    if (core || ctx->hasExtension("GL_ARB_timer_query")) {
+        m_getQueryObjectui64v = reinterpret_cast<GetQueryObjectui64vFn>(ctx->getProcAddress("glGetQueryObjectui64v"));
+    }
+}
+
+void FrameProfiler::destroy()
+{
+    for (const PendingQuery& pending : m_pending) {
+        m_freeQueries.push_back(pending.query);
+    }
+    m_pending.clear();
+    if (!m_freeQueries.empty()) {
+        mp_context->glDeleteQueries(GLsizei(m_freeQueries.size()), m_freeQueries.data());
+        m_freeQueries.clear();
+    }
+    m_getQueryObjectui64v = nullptr;
+}
+
+bool FrameProfiler::isGpuTimingSupported() const
+{
+    return m_getQueryObjectui64v != nullptr;
+}
+
+void FrameProfiler::beginFrame()
+{
+    collectQueries();
+
+    if (m_frames.size() == FRAME_HISTORY) {
+        // Reuse the oldest frame's memory
+        Frame oldest = std::move(m_frames.front());
+        m_frames.pop_front();
+        oldest.events.clear();
+        m_frames.push_back(std::move(oldest));
+    } else {
+        m_frames.emplace_back();
+    }
+    Frame& frame = m_frames.back();
+    frame.number = ++m_frameNumber;
+    frame.startNs = m_clock.nsecsElapsed();
+    m_inFrame = true;
+}
+
+void FrameProfiler::endFrame()
+{
+    m_inFrame = false;
+}
+
+std::size_t FrameProfiler::beginZone(const char* name, bool gpu)
+{
+    if (!m_inFrame) {
+        return std::size_t(-1);
+    }
+    std::vector<Event>& events = m_frames.back().events;
+    events.push_back({name, m_clock.nsecsElapsed(), 0, -1});
+
+    if (gpu && m_getQueryObjectui64v && !m_gpuZoneOpen) {
+        GLuint query;
+        if (m_freeQueries.empty()) {
+            mp_context->glGenQueries(1, &query);
+        } else {
+            query = m_freeQueries.back();
+            m_freeQueries.pop_back();
+        }
+        mp_context->glBeginQuery(GL_TIME_ELAPSED, query);
+        m_pending.push_back({query, m_frameNumber, events.size() - 1});
+        m_gpuZoneOpen = true;
+    }
+    return events.size() - 1;
+}
+
+void FrameProfiler::endZone(std::size_t event)
+{
+    if (!m_inFrame || event == std::size_t(-1)) {
+        return;
+    }
+    Event& e = m_frames.back().events[event];
+    e.cpuNs = m_clock.nsecsElapsed() - e.startNs;
+
+    if (m_gpuZoneOpen && !m_pending.empty() && m_pending.back().frame == m_frameNumber
+            && m_pending.back().event == event) {
+        mp_context->glEndQuery(GL_TIME_ELAPSED);
+        m_gpuZoneOpen = false;
+    }
+}
+
+void FrameProfiler::collectQueries()
+{
+    // Queries finish in the order they were issued, so stop at the first one still running
+    while (!m_pending.empty()) {
+        const PendingQuery& pending = m_pending.front();
+        GLint available = 0;
+        mp_context->glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            break;
+        }
+        GLuint64 elapsed = 0;
+        m_getQueryObjectui64v(pending.query, GL_QUERY_RESULT, &elapsed);
+        // The frame may have dropped out of the history already
+        if (Frame* frame = findFrame(pending.frame)) {
+            frame->events[pending.event].gpuNs = qint64(elapsed);
+        }
+        m_freeQueries.push_back(pending.query);
+        m_pending.pop_front();
+    }
+}
+
+FrameProfiler::Frame* FrameProfiler::findFrame(quint64 number)
+{
+    if (m_frames.empty() || number < m_frames.front().number || number > m_frames.back().number) {
+        return nullptr;
+    }
+    // Frame numbers are consecutive
+    return &m_frames[std::size_t(number - m_frames.front().number)];
+}
+
+std::vector<FrameProfiler::ZoneStats> FrameProfiler::averages() const
+{
+    struct Sum {
+        const char* name;
+        qint64 cpuNs;
+        int cpuCount;
+        qint64 gpuNs;
+        int gpuCount;
+    };
+    std::vector<Sum> sums;
+    for (const Frame& frame : m_frames) {
+        // The frame in progress has incomplete zones
+        if (m_inFrame && &frame == &m_frames.back()) {
+            break;
+        }
+        for (const Event& e : frame.events) {
+            // Few zones, so a linear search beats hashing. Names are string literals.
+            auto it = std::find_if(sums.begin(), sums.end(), [&e](const Sum& s) { return s.name == e.name; });
+            if (it == sums.end()) {
+                sums.push_back({e.name, 0, 0, 0, 0});
+                it = sums.end() - 1;
+            }
+            it->cpuNs += e.cpuNs;
+            it->cpuCount++;
+            if (e.gpuNs >= 0) {
+                it->gpuNs += e.gpuNs;
+                it->gpuCount++;
+            }
+        }
+    }
+
+    std::vector<ZoneStats> stats;
+    stats.reserve(sums.size());
+    for (const Sum& s : sums) {
+        stats.push_back({s.name, s.cpuNs / 1e6f / s.cpuCount, s.gpuCount ? s.gpuNs / 1e6f / s.gpuCount : -1.f});
+    }
+    return stats;
+}
+
+std::vector<float> FrameProfiler::frameIntervals() const
+{
+    std::vector<float> intervals;
+    for (std::size_t i = 1; i < m_frames.size(); i++) {
+        intervals.push_back((m_frames[i].startNs - m_frames[i - 1].startNs) / 1e6f);
+    }
+    return intervals;
+}
+
+bool FrameProfiler::writeTrace(const QString& path) const
+{
+    // Trace event format: complete ("X") events with microsecond timestamps
+    QByteArray json = "{\"traceEvents\":[\n"
+                      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n"
+                      "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    auto addEvent = [&json](const char* name, int track, qint64 startNs, qint64 durationNs) {
+        json += ",\n{\"name\":\"";
+        json += name;
+        json += "\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+        json += QByteArray::number(track);
+        json += ",\"ts\":";
+        json += QByteArray::number(startNs / 1000.0, 'f', 3);
+        json += ",\"dur\":";
+        json += QByteArray::number(durationNs / 1000.0, 'f', 3);
+        json += "}";
+    };
+    for (const Frame& frame : m_frames) {
+        for (const Event& e : frame.events) {
+            addEvent(e.name, 1, e.startNs, e.cpuNs);
+            if (e.gpuNs >= 0) {
+                addEvent(e.name, 2, e.startNs, e.gpuNs);
+            }
+        }
+    }
+    json += "\n]}\n";
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(json);
+    return file.commit();
+}
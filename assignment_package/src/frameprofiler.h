@@ -0,0 +1,100 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <QElapsedTimer>
+#include <QString>
+#include <deque>
+#include <vector>
+
+// Measures where each frame's time goes. Code inside paintGL is split into named
+// zones (see Zone) whose CPU time is always recorded; zones marked as GPU zones
+// are also timed on the GPU with GL_TIME_ELAPSED queries. Query results are only
+// read once the driver reports them available, a few frames later, so measuring
+// never makes the CPU wait for the GPU.
+// The last frames are kept for rolling averages and can be written out as a
+// Chrome trace (chrome://tracing, ui.perfetto.dev).
+class FrameProfiler
+{
+public:
+    // Times the enclosing scope. GPU zones must not be nested in each other.
+    class Zone
+    {
+    public:
+        Zone(FrameProfiler& profiler, const char* name, bool gpu = false);
+        ~Zone();
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        FrameProfiler& m_profiler;
+        std::size_t m_event;
+    };
+
+    // Average time of one zone over the recorded frames, in milliseconds.
+    // gpuMs is negative if the zone isn't timed on the GPU or no result arrived yet.
+    struct ZoneStats {
+        const char* name;
+        float cpuMs;
+        float gpuMs;
+    };
+
+    FrameProfiler(OpenGLContext* context);
+    ~FrameProfiler();
+
+    // Checks for timer query support. Must be called with the context current.
+    void create();
+    void destroy();
+    bool isGpuTimingSupported() const;
+
+    // Brackets one frame. beginFrame() also collects the GPU results that have arrived.
+    void beginFrame();
+    void endFrame();
+
+    // Per zone averages over the recorded frames, in the order the zones first ran
+    std::vector<ZoneStats> averages() const;
+    // Time from the start of each recorded frame to the start of the next, oldest first, in milliseconds
+    std::vector<float> frameIntervals() const;
+
+    // Writes the recorded frames to path as Chrome trace event JSON. GPU times appear on
+    // a track of their own, starting where the CPU issued the zone's commands.
+    bool writeTrace(const QString& path) const;
+
+private:
+    struct Event {
+        const char* name;
+        qint64 startNs; // Since the profiler was created
+        qint64 cpuNs;
+        qint64 gpuNs;   // -1 until the query result arrives, or if not timed on the GPU
+    };
+    struct Frame {
+        quint64 number;
+        qint64 startNs;
+        std::vector<Event> events;
+    };
+    // A timer query whose result hasn't been read yet
+    struct PendingQuery {
+        GLuint query;
+        quint64 frame;
+        std::size_t event;
+    };
+
+    std::size_t beginZone(const char* name, bool gpu);
+    void endZone(std::size_t event);
+    // Reads the results of the queries that have finished, oldest first
+    void collectQueries();
+    Frame* findFrame(quint64 number);
+
+    QElapsedTimer m_clock;
+    std::deque<Frame> m_frames; // The recorded frames, oldest first; the last one is in progress
+    quint64 m_frameNumber;
+    bool m_inFrame;
+
+    std::deque<PendingQuery> m_pending;
+    std::vector<GLuint> m_freeQueries;
+    bool m_gpuZoneOpen; // GL_TIME_ELAPSED queries can't be nested
+
+    typedef void (QOPENGLF_APIENTRYP GetQueryObjectui64vFn)(GLuint, GLenum, GLuint64*);
+    GetQueryObjectui64vFn m_getQueryObjectui64v; // nullptr if timer queries aren't supported
+
+    OpenGLContext* mp_context;
+};
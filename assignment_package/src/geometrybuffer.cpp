@@ -0,0 +1,203 @@
+#include "geometrybuffer.h"
+#include <algorithm>
+
+// Room for this many elements is allocated the first time a buffer is used
+const static GLuint INITIAL_CAPACITY = 1024;
+
+GeometryBuffer::GeometryBuffer(OpenGLContext* context)
+    : m_vertices{GL_ARRAY_BUFFER, sizeof(glm::vec3), 0, 0, {}},
+      m_indices{GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint), 0, 0, {}},
+      m_uploadedBytes(0),
+      mp_context(context)
+{}
+
+GeometryBuffer::~GeometryBuffer()
+{
+    destroy();
+}
+
+void GeometryBuffer::destroy()
+{
+    for (Store* store : {&m_vertices, &m_indices}) {
+        if (store->buffer) {
+            mp_context->glDeleteBuffers(1, &store->buffer);
+        }
+        store->buffer = 0;
+        store->capacity = 0;
+        store->freeSpans.clear();
+    }
+}
+
+GeometryBuffer::Range GeometryBuffer::allocate(const std::vector<glm::vec3>& positions,
+                                               const std::vector<GLuint>& indices)
+{
+    Range range;
+    range.vertexCount = positions.size();
+    range.indexCount = indices.size();
+    range.baseVertex = reserve(m_vertices, range.vertexCount);
+    range.firstIndex = reserve(m_indices, range.indexCount);
+
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_vertices.buffer);
+    mp_context->glBufferSubData(GL_ARRAY_BUFFER, range.baseVertex * sizeof(glm::vec3),
+                                positions.size() * sizeof(glm::vec3), positions.data());
+    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices.buffer);
+    mp_context->glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, range.firstIndex * sizeof(GLuint),
+                                indices.size() * sizeof(GLuint), indices.data());
+    m_uploadedBytes += positions.size() * sizeof(glm::vec3) + indices.size() * sizeof(GLuint);
+    return range;
+}
+
+void GeometryBuffer::free(const Range& range)
+{
+    release(m_vertices, range.baseVertex, range.vertexCount);
+    release(m_indices, range.firstIndex, range.indexCount);
+}
+
+bool GeometryBuffer::bindPos()
+{
+    if (m_vertices.buffer) {
+        mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_vertices.buffer);
+    }
+    return m_vertices.buffer != 0;
+}
+
+bool GeometryBuffer::bindIdx()
+{
+    if (m_indices.buffer) {
+        mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indices.buffer);
+    }
+    return m_indices.buffer != 0;
+}
+
+GLuint GeometryBuffer::vertexCapacity() const
+{
+    return m_vertices.capacity;
+}
+
+GLuint GeometryBuffer::indexCapacity() const
+{
+    return m_indices.capacity;
+}
+
+GLuint GeometryBuffer::vertexCount() const
+{
+    return usedCount(m_vertices);
+}
+
+GLuint GeometryBuffer::indexCount() const
+{
+    return usedCount(m_indices);
+}
+
+std::size_t GeometryBuffer::freeSpanCount() const
+{
+    return m_vertices.freeSpans.size() + m_indices.freeSpans.size();
+}
+
+std::size_t GeometryBuffer::takeUploadedBytes()
+{
+    std::size_t bytes = m_uploadedBytes;
+    m_uploadedBytes = 0;
+    return bytes;
+}
+
+GLuint GeometryBuffer::usedCount(const Store& store)
+{
+    GLuint used = store.capacity;
+    for (const Span& span : store.freeSpans) {
+        used -= span.size;
+    }
+    return used;
+}
+
+GLuint GeometryBuffer::reserve(Store& store, GLuint count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    // First fit: shapes are few and mostly long-lived, so fragmentation stays low
+    for (auto it = store.freeSpans.begin(); it != store.freeSpans.end(); ++it) {
+        if (it->size >= count) {
+            GLuint offset = it->offset;
+            it->offset += count;
+            it->size -= count;
+            if (it->size == 0) {
+                store.freeSpans.erase(it);
+            }
+            return offset;
+        }
+    }
+
+    // Double the buffer until the request fits into the space at its end
+    GLuint tailFree = 0;
+    if (!store.freeSpans.empty()
+            && store.freeSpans.back().offset + store.freeSpans.back().size == store.capacity) {
+        tailFree = store.freeSpans.back().size;
+    }
+    GLuint capacity = std::max(store.capacity, INITIAL_CAPACITY);
+    while (capacity - store.capacity + tailFree < count) {
+        capacity *= 2;
+    }
+    grow(store, capacity);
+    return reserve(store, count);
+}
+
+void GeometryBuffer::release(Store& store, GLuint offset, GLuint count)
+{
+    if (count == 0) {
+        return;
+    }
+    auto next = std::lower_bound(store.freeSpans.begin(), store.freeSpans.end(), offset,
+                                 [](const Span& s, GLuint o) { return s.offset < o; });
+    // Merge with the span ending right where this one starts
+    if (next != store.freeSpans.begin()) {
+        auto prev = std::prev(next);
+        if (prev->offset + prev->size == offset) {
+            prev->size += count;
+            if (next != store.freeSpans.end() && prev->offset + prev->size == next->offset) {
+                prev->size += next->size;
+                store.freeSpans.erase(next);
+            }
+            return;
+        }
+    }
+    // ...or with the one starting right where it ends
+    if (next != store.freeSpans.end() && offset + count == next->offset) {
+        next->offset = offset;
+        next->size += count;
+        return;
+    }
+    store.freeSpans.insert(next, {offset, count});
+}
+
+void GeometryBuffer::grow(Store& store, GLuint capacity)
+{
+    GLuint oldCapacity = store.capacity;
+    if (!store.buffer) {
+        mp_context->glGenBuffers(1, &store.buffer);
+    }
+
+    // Keep the buffer's name, so bindings made by Drawables stay valid:
+    // park the old contents in a temporary buffer while this one is reallocated
+    GLuint temp = 0;
+    if (oldCapacity > 0) {
+        mp_context->glGenBuffers(1, &temp);
+        mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, temp);
+        mp_context->glBufferData(GL_COPY_WRITE_BUFFER, oldCapacity * store.elemSize, nullptr, GL_STREAM_COPY);
+        mp_context->glBindBuffer(GL_COPY_READ_BUFFER, store.buffer);
+        mp_context->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * store.elemSize);
+    }
+
+    mp_context->glBindBuffer(store.target, store.buffer);
+    mp_context->glBufferData(store.target, capacity * store.elemSize, nullptr, GL_STATIC_DRAW);
+
+    if (temp) {
+        mp_context->glBindBuffer(GL_COPY_READ_BUFFER, temp);
+        mp_context->glBindBuffer(GL_COPY_WRITE_BUFFER, store.buffer);
+        mp_context->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldCapacity * store.elemSize);
+        mp_context->glDeleteBuffers(1, &temp);
+    }
+
+    store.capacity = capacity;
+    release(store, oldCapacity, capacity - oldCapacity);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <la.h>
+#include <vector>
+
+// One vertex buffer and one index buffer that many Drawables share.
+// Each Drawable gets its own range of vertices and indices; its indices
+// count from 0, and the range's base vertex is added to them when drawing
+// with glDrawElementsBaseVertex. Binding the two buffers once is then
+// enough to draw every shape stored in them.
+class GeometryBuffer
+{
+public:
+    // Where one Drawable's data lives in the shared buffers
+    struct Range {
+        GLint baseVertex;   // Index of the first vertex in the vertex buffer
+        GLuint firstIndex;  // Index of the first entry in the index buffer
+        GLuint vertexCount;
+        GLuint indexCount;
+    };
+
+    GeometryBuffer(OpenGLContext* context);
+    ~GeometryBuffer();
+
+    // Copies the given vertices and indices into free space in the buffers, growing them if needed.
+    // The context must be current.
+    Range allocate(const std::vector<glm::vec3>& positions, const std::vector<GLuint>& indices);
+    // Makes a range returned by allocate available again. Its contents are left as they are.
+    void free(const Range& range);
+
+    // Frees the GPU buffers. The context must be current.
+    void destroy();
+
+    // Bind the shared buffers. Return false if nothing has been allocated yet.
+    bool bindPos();
+    bool bindIdx();
+
+    // Number of vertices / indices the buffers currently have room for
+    GLuint vertexCapacity() const;
+    GLuint indexCapacity() const;
+    // Number of vertices / indices handed out by allocate() and not freed yet
+    GLuint vertexCount() const;
+    GLuint indexCount() const;
+    // Number of separate runs of free space, across both buffers. Many small ones mean fragmentation.
+    std::size_t freeSpanCount() const;
+    // Bytes copied into the buffers by allocate() since the last call
+    std::size_t takeUploadedBytes();
+
+private:
+    // A run of unused elements in one of the buffers
+    struct Span {
+        GLuint offset;
+        GLuint size;
+    };
+
+    // One of the two buffers together with its free space
+    struct Store {
+        GLenum target;
+        GLuint elemSize;       // Bytes per element
+        GLuint buffer;         // 0 until the first allocation
+        GLuint capacity;       // In elements
+        std::vector<Span> freeSpans; // Sorted by offset, never adjacent to each other
+    };
+
+    // Finds room for count elements in store, growing it if there is none, and returns the offset
+    GLuint reserve(Store& store, GLuint count);
+    // Returns [offset, offset + count) to store's free list, merging it with its neighbours
+    void release(Store& store, GLuint offset, GLuint count);
+    // Reallocates store with room for at least capacity elements, keeping its contents and buffer name
+    void grow(Store& store, GLuint capacity);
+
+    // Elements of store not in any free span
+    static GLuint usedCount(const Store& store);
+
+    Store m_vertices;
+    Store m_indices;
+    std::size_t m_uploadedBytes; // Since the last takeUploadedBytes()
+
+    OpenGLContext* mp_context;
+};
@@ -0,0 +1,226 @@
+#include "hudoverlay.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Size in pixels of one pixel of the font
+const static float FONT_SCALE = 2.f;
+// A glyph is 3 font pixels wide and 5 high; characters and lines are spaced one font pixel apart
+const static float CHAR_ADVANCE = 4.f * FONT_SCALE;
+const static float LINE_HEIGHT = 7.f * FONT_SCALE;
+// Space between the panel's edge and its contents, and between the panel and the widget's corner
+const static float PADDING = 8.f;
+// Height in pixels of the frame time graph, and the frame time shown at its top
+const static float GRAPH_HEIGHT = 48.f;
+const static float GRAPH_MAX_MS = 50.f;
+// Frames up to these lengths are drawn green / yellow in the graph, longer ones red
+const static float GOOD_FRAME_MS = 1000.f / 60.f;
+const static float OK_FRAME_MS = 1000.f / 30.f;
+
+const static glm::vec3 PANEL_COLOR(0.1f, 0.1f, 0.1f);
+const static glm::vec3 TEXT_COLOR(0.9f, 0.9f, 0.9f);
+const static glm::vec3 GOOD_COLOR(0.3f, 0.85f, 0.3f);
+const static glm::vec3 OK_COLOR(0.9f, 0.8f, 0.2f);
+const static glm::vec3 BAD_COLOR(0.9f, 0.25f, 0.2f);
+
+// Each glyph is 5 rows of 3 bits, top row first, leftmost pixel in the highest bit
+const static char GLYPH_CHARS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.:/%-()";
+const static unsigned short GLYPHS[] = {
+    0b111'101'101'101'111, 0b010'110'010'010'111, 0b111'001'111'100'111, 0b111'001'111'001'111,
+    0b101'101'111'001'001, 0b111'100'111'001'111, 0b111'100'111'101'111, 0b111'001'001'001'001,
+    0b111'101'111'101'111, 0b111'101'111'001'111,
+    0b010'101'111'101'101, 0b110'101'110'101'110, 0b011'100'100'100'011, 0b110'101'101'101'110,
+    0b111'100'110'100'111, 0b111'100'110'100'100, 0b011'100'101'101'011, 0b101'101'111'101'101,
+    0b111'010'010'010'111, 0b001'001'001'101'010, 0b101'101'110'101'101, 0b100'100'100'100'111,
+    0b101'111'111'101'101, 0b110'101'101'101'101, 0b010'101'101'101'010, 0b110'101'110'100'100,
+    0b010'101'101'110'011, 0b110'101'110'101'101, 0b011'100'010'001'110, 0b111'010'010'010'010,
+    0b101'101'101'101'111, 0b101'101'101'101'010, 0b101'101'111'111'101, 0b101'101'010'101'101,
+    0b101'101'010'010'010, 0b111'001'010'100'111,
+    0b000'000'000'000'010, 0b000'010'000'010'000, 0b001'001'010'100'100, 0b101'001'010'100'101,
+    0b000'000'111'000'000, 0b001'010'010'010'001, 0b100'010'010'010'100,
+};
+static_assert(sizeof(GLYPHS) / sizeof(GLYPHS[0]) == sizeof(GLYPH_CHARS) - 1, "one glyph per character");
+
+HudOverlay::HudOverlay(OpenGLContext* context)
+    : Drawable(context), m_positions(), m_colors(), m_indices()
+{}
+
+void HudOverlay::create()
+{
+    generateIdx();
+    generatePos();
+    generateCol();
+    m_count = 0;
+}
+
+glm::mat3 HudOverlay::pixelToNdc(int width, int height)
+{
+    // y points down in pixels and up in normalized device coordinates
+    return glm::mat3(glm::vec3(2.f / std::max(width, 1), 0.f, 0.f),
+                     glm::vec3(0.f, -2.f / std::max(height, 1), 0.f),
+                     glm::vec3(-1.f, 1.f, 1.f));
+}
+
+void HudOverlay::addRect(float x, float y, float width, float height, const glm::vec3& color)
+{
+    GLuint first = GLuint(m_positions.size());
+    m_positions.push_back(glm::vec3(x, y, 1.f));
+    m_positions.push_back(glm::vec3(x + width, y, 1.f));
+    m_positions.push_back(glm::vec3(x + width, y + height, 1.f));
+    m_positions.push_back(glm::vec3(x, y + height, 1.f));
+    m_colors.insert(m_colors.end(), 4, color);
+    for (GLuint i : {0u, 1u, 2u, 0u, 2u, 3u}) {
+        m_indices.push_back(first + i);
+    }
+}
+
+void HudOverlay::addText(float x, float y, const char* text, const glm::vec3& color)
+{
+    for (const char* c = text; *c; c++, x += CHAR_ADVANCE) {
+        const char* found = std::strchr(GLYPH_CHARS, std::toupper(static_cast<unsigned char>(*c)));
+        if (*c == ' ' || !found) {
+            continue;
+        }
+        unsigned short glyph = GLYPHS[found - GLYPH_CHARS];
+        for (int row = 0; row < 5; row++) {
+            int bits = (glyph >> (3 * (4 - row))) & 0b111;
+            // One rectangle per run of lit pixels in the row
+            for (int col = 0; col < 3; col++) {
+                if (!(bits & (0b100 >> col))) {
+                    continue;
+                }
+                int end = col;
+                while (end + 1 < 3 && (bits & (0b100 >> (end + 1)))) {
+                    end++;
+                }
+                addRect(x + col * FONT_SCALE, y + row * FONT_SCALE, (end - col + 1) * FONT_SCALE, FONT_SCALE, color);
+                col = end;
+            }
+        }
+    }
+}
+
+// Writes bytes to out with a unit that keeps it short
+static void formatBytes(char* out, std::size_t size, double bytes)
+{
+    const char* units[] = {"b", "kb", "mb", "gb"};
+    int unit = 0;
+    while (unit < 3 && bytes >= 1024.0) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    std::snprintf(out, size, unit ? "%.1f %s" : "%.0f %s", bytes, units[unit]);
+}
+
+void HudOverlay::update(const Stats& stats, const MemoryReport& memory,
+                        const std::vector<FrameProfiler::ZoneStats>& zones, const std::vector<float>& frameIntervals)
+{
+    m_positions.clear();
+    m_colors.clear();
+    m_indices.clear();
+
+    // The panel goes first so everything else is drawn over it. Its size is only
+    // known at the end, so its corners are filled in then.
+    addRect(0.f, 0.f, 0.f, 0.f, PANEL_COLOR);
+
+    std::vector<std::string> lines;
+    char line[128];
+    float averageMs = 0.f;
+    for (float ms : frameIntervals) {
+        averageMs += ms;
+    }
+    averageMs = frameIntervals.empty() ? 0.f : averageMs / frameIntervals.size();
+    std::snprintf(line, sizeof(line), "frame %.2f ms  %.0f fps", averageMs, averageMs > 0.f ? 1000.f / averageMs : 0.f);
+    lines.push_back(line);
+
+    float x = PADDING + PADDING;
+    float y = PADDING + PADDING;
+    addText(x, y, lines.back().c_str(), TEXT_COLOR);
+    y += LINE_HEIGHT;
+
+    // Frame time graph, newest frame on the right
+    float graphWidth = float(frameIntervals.size());
+    for (std::size_t i = 0; i < frameIntervals.size(); i++) {
+        float ms = frameIntervals[i];
+        float height = std::min(ms, GRAPH_MAX_MS) / GRAPH_MAX_MS * GRAPH_HEIGHT;
+        const glm::vec3& color = ms <= GOOD_FRAME_MS ? GOOD_COLOR : ms <= OK_FRAME_MS ? OK_COLOR : BAD_COLOR;
+        addRect(x + i, y + GRAPH_HEIGHT - height, 1.f, height, color);
+    }
+    // Marks the 60 fps budget
+    addRect(x, y + GRAPH_HEIGHT - GOOD_FRAME_MS / GRAPH_MAX_MS * GRAPH_HEIGHT, graphWidth, 1.f, TEXT_COLOR);
+    y += GRAPH_HEIGHT + LINE_HEIGHT / 2;
+
+    std::snprintf(line, sizeof(line), "%-10s %8s %8s", "zone", "cpu ms", "gpu ms");
+    lines.push_back(line);
+    for (const FrameProfiler::ZoneStats& zone : zones) {
+        char gpu[16] = "-";
+        if (zone.gpuMs >= 0.f) {
+            std::snprintf(gpu, sizeof(gpu), "%.3f", zone.gpuMs);
+        }
+        std::snprintf(line, sizeof(line), "%-10s %8.3f %8s", zone.name, zone.cpuMs, gpu);
+        lines.push_back(line);
+    }
+    std::snprintf(line, sizeof(line), "draw calls %zu  triangles %zu", stats.drawCalls, stats.triangles);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "nodes %zu  culled %zu  dirty %zu",
+                  stats.nodesVisited, stats.nodesCulled, stats.nodesDirty);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "subtrees skipped %zu", stats.subtreesCulled);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "upload %.1f kb", stats.uploadBytes / 1024.0);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "shapes %zu  free spans %zu", stats.shapes, stats.freeSpans);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "vertices %u / %u", stats.vertexCount, stats.vertexCapacity);
+    lines.push_back(line);
+    std::snprintf(line, sizeof(line), "indices %u / %u", stats.indexCount, stats.indexCapacity);
+    lines.push_back(line);
+    if (stats.shaderReloadBlocks) {
+        lines.push_back("shader reloads block the gui");
+    }
+
+    char a[16], b[16], c[16];
+    formatBytes(a, sizeof(a), memory.sceneBytes());
+    formatBytes(b, sizeof(b), memory.nodeCount ? double(memory.sceneBytes()) / memory.nodeCount : 0.0);
+    std::snprintf(line, sizeof(line), "scene %s  %zu nodes  %s each", a, memory.nodeCount, b);
+    lines.push_back(line);
+    formatBytes(a, sizeof(a), memory.nodeBytes);
+    formatBytes(b, sizeof(b), memory.nameBytes);
+    formatBytes(c, sizeof(c), memory.childrenBytes);
+    std::snprintf(line, sizeof(line), " nodes %s  names %s  children %s", a, b, c);
+    lines.push_back(line);
+    formatBytes(a, sizeof(a), memory.polygonBytes + memory.cpuGeometryBytes + memory.registryBytes);
+    formatBytes(b, sizeof(b), memory.gpuBytes);
+    formatBytes(c, sizeof(c), memory.gpuReservedBytes);
+    std::snprintf(line, sizeof(line), "geometry cpu %s  gpu %s / %s", a, b, c);
+    lines.push_back(line);
+
+    std::size_t longest = 0;
+    for (std::size_t i = 0; i < lines.size(); i++) {
+        longest = std::max(longest, lines[i].size());
+        // The first line was written above the graph
+        if (i > 0) {
+            addText(x, y, lines[i].c_str(), TEXT_COLOR);
+            y += LINE_HEIGHT;
+        }
+    }
+
+    float panelRight = x + std::max(graphWidth, longest * CHAR_ADVANCE) + PADDING;
+    float panelBottom = y + PADDING - (LINE_HEIGHT - 5.f * FONT_SCALE);
+    m_positions[0] = glm::vec3(PADDING, PADDING, 1.f);
+    m_positions[1] = glm::vec3(panelRight, PADDING, 1.f);
+    m_positions[2] = glm::vec3(panelRight, panelBottom, 1.f);
+    m_positions[3] = glm::vec3(PADDING, panelBottom, 1.f);
+
+    // Replace the buffers' contents every frame; the driver can hand out fresh memory
+    // instead of waiting for last frame's draw to finish with the old one
+    m_count = int(m_indices.size());
+    mp_context->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_bufIdx);
+    mp_context->glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), m_indices.data(), GL_STREAM_DRAW);
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPos);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, m_positions.size() * sizeof(glm::vec3), m_positions.data(), GL_STREAM_DRAW);
+    mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufCol);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, m_colors.size() * sizeof(glm::vec3), m_colors.data(), GL_STREAM_DRAW);
+}
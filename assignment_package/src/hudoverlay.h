@@ -0,0 +1,55 @@
+#pragma once
+
+#include "drawable.h"
+#include "frameprofiler.h"
+#include "memoryreport.h"
+#include <vector>
+
+// Performance statistics drawn over the scene: a graph of recent frame times,
+// the profiler's zone timings, the counters in Stats and a MemoryReport.
+// Text uses a built-in 3x5 pixel font whose lit pixels become small rectangles,
+// so the whole overlay is plain colored triangles in one set of buffers and is
+// drawn with a single draw call by ShaderProgram::draw.
+class HudOverlay : public Drawable
+{
+public:
+    // What the last frame did. Filled in by MyGL while drawing.
+    struct Stats {
+        std::size_t drawCalls;
+        std::size_t triangles;
+        std::size_t nodesVisited;
+        std::size_t nodesCulled;  // Visited, but outside the view
+        std::size_t subtreesCulled; // Skipped whole: unchanged and outside the view
+        std::size_t nodesDirty;   // Whose world transformation was recomputed
+        std::size_t uploadBytes;  // Geometry, instances and commands sent to the GPU
+        // State of the GeometryBuffer allocator
+        std::size_t shapes;
+        GLuint vertexCount;
+        GLuint vertexCapacity;
+        GLuint indexCount;
+        GLuint indexCapacity;
+        std::size_t freeSpans;
+        // Shader hot reload is on, and each reload stalls the GUI thread while the driver
+        // compiles: no parallel compile extension and no OpenGL context on a worker thread
+        bool shaderReloadBlocks;
+    };
+
+    HudOverlay(OpenGLContext* context);
+    void create() override;
+
+    // Rebuilds the overlay from the given numbers and uploads it.
+    // Positions are in pixels from the top left corner of the widget.
+    void update(const Stats& stats, const MemoryReport& memory,
+                const std::vector<FrameProfiler::ZoneStats>& zones, const std::vector<float>& frameIntervals);
+    // The model matrix that maps the pixel positions update() uses to normalized device coordinates
+    static glm::mat3 pixelToNdc(int width, int height);
+
+private:
+    void addRect(float x, float y, float width, float height, const glm::vec3& color);
+    // Writes text with its top left corner at (x, y). Lowercase letters are shown as capitals.
+    void addText(float x, float y, const char* text, const glm::vec3& color);
+
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_colors;
+    std::vector<GLuint> m_indices;
+};
@@ -1,8 +1,12 @@
 #include <mainwindow.h>
+#include "thumbnailbatch.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QCoreApplication>
 #include <QSurfaceFormat>
 #include <QDebug>
+#include <QDir>
 
 void debugFormatVersion()
 {
@@ -19,8 +23,45 @@ void debugFormatVersion()
     printf("  Profile: %s\n", profile);
 }
 
+// Batch mode: renders every scene file given on the command line to a PNG, without opening a window.
+//   SceneGraph --thumbnails <output dir> [--size <pixels>] [--threads <count>] scene.json...
+static int runThumbnails(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders PNG previews of scene files on the CPU.");
+    parser.addHelpOption();
+    QCommandLineOption outputOption("thumbnails", "Directory to write the images to.", "dir");
+    QCommandLineOption sizeOption("size", "Width and height of the images in pixels (default 256).", "pixels", "256");
+    QCommandLineOption threadsOption("threads", "Number of render threads (default: one per core).", "count", "0");
+    parser.addOption(outputOption);
+    parser.addOption(sizeOption);
+    parser.addOption(threadsOption);
+    parser.addPositionalArgument("scenes", "Scene files to render.", "scene.json...");
+    parser.process(app);
+
+    int size = parser.value(sizeOption).toInt();
+    int threads = parser.value(threadsOption).toInt();
+    if (size <= 0 || threads < 0 || parser.positionalArguments().isEmpty()) {
+        parser.showHelp(1);
+    }
+    QDir().mkpath(parser.value(outputOption));
+
+    ThumbnailBatch batch(parser.value(outputOption), size, size, unsigned(threads));
+    int failed = batch.run(parser.positionalArguments());
+    printf("Rendered %d of %d scenes\n", int(parser.positionalArguments().size()) - failed,
+           int(parser.positionalArguments().size()));
+    return failed ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++) {
+        if (QByteArray(argv[i]).startsWith("--thumbnails")) {
+            return runThumbnails(argc, argv);
+        }
+    }
+
     QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QApplication a(argc, argv);
 
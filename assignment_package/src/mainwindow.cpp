@@ -8,24 +8,39 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
     ui->mygl->setFocus();
+    mp_sceneTree = new SceneTree(ui->treeWidget, this);
 
     // Connects MyGL's signal that contains the root node of
-    // your scene graph to a slot in MainWindow that adds the
-    // root node to the GUI's Tree Widget.
+    // your scene graph to a slot in MainWindow that shows the
+    // root node in the GUI's Tree Widget.
             // Widget that emits the signal
     connect(ui->mygl,
             // Signal name
-            SIGNAL(sig_sendRootNode(QTreeWidgetItem*)),
+            SIGNAL(sig_sendRootNode(Node*)),
             // Widget with the slot that receives the signal
             this,
             // Slot name
-            SLOT(slot_addRootToTreeWidget(QTreeWidgetItem*)));
+            SLOT(slot_setTreeRoot(Node*)));
+    // Every later edit of the scene graph's structure reaches the
+    // Tree Widget in batches, which only touch the affected rows.
+    connect(ui->mygl, SIGNAL(sig_sceneChanged(SceneChangeBatch)),
+            mp_sceneTree, SLOT(slot_applyChanges(SceneChangeBatch)));
 
-    // Connects the Tree Widget's signal containing the Node that you
+    // Connects the Tree Widget's signal containing the row that you
     // clicked on to MyGL's slot that updates MyGL's mp_selectedNode
     // member variable to the clicked Node.
     connect(ui->treeWidget, SIGNAL(itemClicked(QTreeWidgetItem*,int)),
-            ui->mygl, SLOT(slot_setSelectedNode(QTreeWidgetItem*)));
+            this, SLOT(slot_forwardClickedItem(QTreeWidgetItem*)));
+
+    // The Tree Widget allows selecting many Nodes at once (Ctrl / Shift + click);
+    // every change of that selection is forwarded to MyGL for bulk editing.
+    connect(ui->treeWidget, SIGNAL(itemSelectionChanged()),
+            this, SLOT(slot_forwardTreeSelection()));
+    // Nodes clicked in the viewport get selected in the Tree Widget
+    connect(ui->mygl, SIGNAL(sig_pickNode(Node*,bool)),
+            this, SLOT(slot_selectPickedNode(Node*,bool)));
+    connect(ui->relativeCheckBox, SIGNAL(toggled(bool)),
+            ui->mygl, SLOT(slot_setRelativeEdits(bool)));
 
     // Connects the X-translate spin box's signal containing its new value
     // to MyGL, which has a slot that will update the selected node's
@@ -47,12 +62,35 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->sySpinBox, SIGNAL(valueChanged(double)),
             ui->mygl, SLOT(slot_setScaleY(double)));
 
+    // Every value a spin box goes through while it is being edited is merged into one
+    // undo entry, which ends when the spin box finishes editing
+    for (QDoubleSpinBox* spinBox : {ui->txSpinBox, ui->tySpinBox, ui->rSpinBox, ui->sxSpinBox, ui->sySpinBox}) {
+        connect(spinBox, SIGNAL(editingFinished()),
+                ui->mygl, SLOT(slot_finishEdit()));
+    }
+
     // Connects the "Add Translate Node" button's "clicked" signal
     // to a slot in MyGL that will add a child to the currently selected
     // Node.
     connect(ui->tNodeAddButton, SIGNAL(clicked()),
             ui->mygl, SLOT(slot_addTranslateNode()));
 
+    // Connects the "Set Geometry" button and the spin box choosing its number of sides
+    connect(ui->geomSetButton, SIGNAL(clicked()),
+            ui->mygl, SLOT(slot_setGeometry()));
+    connect(ui->sidesSpinBox, SIGNAL(valueChanged(int)),
+            ui->mygl, SLOT(slot_setGeometrySides(int)));
+
+    // Connects the Edit menu's "Duplicate Node" action to a slot in MyGL
+    // that copies the selected Node's whole subtree next to it.
+    connect(ui->actionDuplicate, SIGNAL(triggered()),
+            ui->mygl, SLOT(slot_duplicateSelectedNode()));
+
+    connect(ui->actionUndo, SIGNAL(triggered()),
+            ui->mygl, SLOT(slot_undo()));
+    connect(ui->actionRedo, SIGNAL(triggered()),
+            ui->mygl, SLOT(slot_redo()));
+
 
     ui->treeWidget->setStyleSheet("background-color: lightblue; color: white;");
 //    ui->centralWidget->setStyleSheet("background-color: #333333; border: 1px solid black;");
@@ -70,6 +108,26 @@ void MainWindow::on_actionQuit_triggered()
     QApplication::exit();
 }
 
-void MainWindow::slot_addRootToTreeWidget(QTreeWidgetItem *i) {
-    ui->treeWidget->addTopLevelItem(i);
+void MainWindow::slot_setTreeRoot(Node *root) {
+    mp_sceneTree->setRoot(root);
+}
+
+void MainWindow::slot_forwardClickedItem(QTreeWidgetItem *i) {
+    ui->mygl->slot_setSelectedNode(SceneTree::nodeOf(i));
+}
+
+void MainWindow::slot_forwardTreeSelection() {
+    ui->mygl->slot_setSelectedNodes(mp_sceneTree->selectedNodes());
+}
+
+void MainWindow::slot_selectPickedNode(Node *n, bool additive) {
+    if (!additive) {
+        ui->treeWidget->clearSelection();
+    }
+    // Makes rows down to the node if its branch was never opened
+    QTreeWidgetItem* i = mp_sceneTree->itemFor(n);
+    if (i) {
+        i->setSelected(!additive || !i->isSelected());
+        ui->treeWidget->scrollToItem(i);
+    }
 }
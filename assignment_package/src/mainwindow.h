@@ -2,6 +2,7 @@
 
 #include <QMainWindow>
 #include <QTreeWidgetItem>
+#include "scenetree.h"
 
 
 namespace Ui {
@@ -19,8 +20,17 @@ public:
 
 private slots:
     void on_actionQuit_triggered();
-    void slot_addRootToTreeWidget(QTreeWidgetItem*);
+    // Shows MyGL's scene graph in the Tree Widget
+    void slot_setTreeRoot(Node*);
+    // Sends the node of a clicked row to MyGL
+    void slot_forwardClickedItem(QTreeWidgetItem*);
+    // Sends the Tree Widget's current selection to MyGL
+    void slot_forwardTreeSelection();
+    // Selects the item of a Node clicked in the viewport. If additive,
+    // its selection is toggled and the rest of the selection is kept.
+    void slot_selectPickedNode(Node*, bool additive);
 
 private:
     Ui::MainWindow *ui;
+    SceneTree* mp_sceneTree; // The Tree Widget's rows, kept up to date with MyGL's edits
 };
@@ -0,0 +1,73 @@
+#include "memoryreport.h"
+
+MemoryReport::MemoryReport()
+    : nodeCount(0), nodeBytes(0), nameBytes(0), childrenBytes(0),
+      polygonCount(0), polygonBytes(0), cpuGeometryBytes(0), registryBytes(0),
+      gpuBytes(0), gpuReservedBytes(0)
+{}
+
+// Size of the most derived class of node
+static std::size_t objectSize(const Node& node)
+{
+    switch (node.getType()) {
+    case NodeType::Translate:
+        return sizeof(TranslateNode);
+    case NodeType::Rotate:
+        return sizeof(RotateNode);
+    case NodeType::Scale:
+        return sizeof(ScaleNode);
+    case NodeType::Plain:
+        break;
+    }
+    return sizeof(Node);
+}
+
+void MemoryReport::addScene(const Node& root)
+{
+    // Every scene shares the one table
+    nameBytes = NameTable::memoryBytes();
+    std::vector<const Node*> stack = {&root};
+    while (!stack.empty()) {
+        const Node* node = stack.back();
+        stack.pop_back();
+
+        nodeCount++;
+        nodeBytes += objectSize(*node);
+
+        const Node::ChildList& children = node->getChildren();
+        childrenBytes += children.heapBytes();
+        for (const uPtr<Node>& child : children) {
+            stack.push_back(child.get());
+        }
+    }
+}
+
+void MemoryReport::addGeometry(const GeometryRegistry& geometry)
+{
+    for (const Polygon2D* polygon : geometry.polygons()) {
+        polygonCount++;
+        polygonBytes += sizeof(Polygon2D);
+        cpuGeometryBytes += polygon->cpuBytes();
+        gpuBytes += polygon->gpuBytes();
+    }
+    registryBytes += geometry.keyBytes();
+    const GeometryBuffer& buffer = geometry.buffer();
+    gpuReservedBytes += buffer.vertexCapacity() * sizeof(glm::vec3) + buffer.indexCapacity() * sizeof(GLuint);
+}
+
+void MemoryReport::addDrawable(const Drawable& drawable)
+{
+    std::size_t bytes = drawable.gpuBytes();
+    gpuBytes += bytes;
+    gpuReservedBytes += bytes;
+}
+
+std::size_t MemoryReport::sceneBytes() const
+{
+    return nodeBytes + nameBytes + childrenBytes;
+}
+
+std::size_t MemoryReport::cpuBytes() const
+{
+    return sceneBytes() + polygonBytes + cpuGeometryBytes + registryBytes;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "scene/node.h"
+#include "scene/geometryregistry.h"
+
+// How many bytes a scene takes, broken down by where they are. Fill it in with the
+// add functions; each adds to the totals. Allocator overhead isn't counted, and neither
+// are the Tree Widget's rows, which only exist for the nodes it shows.
+struct MemoryReport {
+    // Scene graph
+    std::size_t nodeCount;
+    std::size_t nodeBytes;        // The Node objects
+    std::size_t nameBytes;        // The NameTable, which every scene shares
+    std::size_t childrenBytes;    // Storage of the children lists that outgrew the node
+    // Geometry
+    std::size_t polygonCount;
+    std::size_t polygonBytes;     // The Polygon2D objects
+    std::size_t cpuGeometryBytes; // Positions and indices that create() hasn't uploaded and freed yet
+    std::size_t registryBytes;    // GeometryRegistry's lookup copies of each shape's positions
+    std::size_t gpuBytes;         // Buffer memory used by the added Drawables
+    std::size_t gpuReservedBytes; // Buffer memory allocated, including unused room in shared buffers
+
+    MemoryReport();
+
+    // Adds the nodes of the scene graph under root
+    void addScene(const Node& root);
+    // Adds every polygon registered in geometry and its shared buffer.
+    // Must be called with the OpenGL context current, if geometry has one.
+    void addGeometry(const GeometryRegistry& geometry);
+    // Adds a Drawable with buffers of its own, such as the grid. Must be called with its context current.
+    void addDrawable(const Drawable& drawable);
+
+    // Everything in the scene graph; divide by nodeCount for the cost of a node
+    std::size_t sceneBytes() const;
+    // Everything on the CPU
+    std::size_t cpuBytes() const;
+};
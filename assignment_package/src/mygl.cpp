@@ -1,23 +1,59 @@
 #include "mygl.h"
 #include <la.h>
+#include <cmath>
 
 #include <iostream>
 #include <QApplication>
+#include <QDebug>
 #include <QKeyEvent>
+#include <QMouseEvent>
+#include <QTimer>
+#include <QWheelEvent>
 
+// Where the T key saves a trace of the last frames
+const static char* TRACE_FILE = "trace.json";
+
+// Frames between two updates of the HUD's memory report; about a second
+const static int MEMORY_REPORT_INTERVAL = 60;
+
+// How much one notch of the mouse wheel zooms
+const static float WHEEL_ZOOM_PER_NOTCH = 1.2f;
+
+// Maximum number of edits that can be undone
+const static std::size_t JOURNAL_CAPACITY = 1000;
+
+// Corners of the axis-aligned unit square most of the scene graph is built from
+const static std::vector<glm::vec3> SQUARE_POSITIONS = {glm::vec3(0.5f, 0.5f, 1.f),
+                                                        glm::vec3(-0.5f, 0.5f, 1.f),
+                                                        glm::vec3(-0.5f, -0.5f, 1.f),
+                                                        glm::vec3(0.5f, -0.5f, 1.f)};
 
 MyGL::MyGL(QWidget *parent)
     : OpenGLContext(parent),
       prog_flat(this),
-      m_geomGrid(this), m_geomSquare(this, {glm::vec3(0.5f, 0.5f, 1.f),
-                                            glm::vec3(-0.5f, 0.5f, 1.f),
-                                            glm::vec3(-0.5f, -0.5f, 1.f),
-                                            glm::vec3(0.5f, -0.5f, 1.f)}),
-      m_geomTriangle(this, 3),
+      m_geomGrid(this), m_geometry(this), m_renderQueue(), m_batches(this), m_profiler(this),
       m_showGrid(true),
-      mp_selectedNode(nullptr)
+      m_hud(this), m_showHud(false), m_frameStats(), m_memory(), m_framesSinceMemoryReport(0),
+      mp_selectedNode(nullptr),
+      m_sceneChanges(),
+      m_journal(JOURNAL_CAPACITY, &m_sceneChanges),
+      m_selection(),
+      m_relativeEdits(false),
+      m_lastSpinBoxValue(),
+      m_camera(), m_panning(false), m_lastMousePos(),
+      m_geometrySides(4),
+      m_shaderDir(), m_shaderWatcher(), m_shaderFilesChanged(false),
+      m_pendingVertSource(), m_pendingFragSource(), m_shaderReloadReady(false)
 {
     setFocusPolicy(Qt::StrongFocus);
+    // However many edits a slot makes, the Tree Widget gets them together once it returns
+    m_sceneChanges.setNotify([this]() {
+        QTimer::singleShot(0, this, [this]() {
+            if (!m_sceneChanges.empty()) {
+                emit sig_sceneChanged(m_sceneChanges.take());
+            }
+        });
+    });
 }
 
 MyGL::~MyGL()
@@ -25,8 +61,10 @@ MyGL::~MyGL()
     makeCurrent();
 
     glDeleteVertexArrays(1, &vao);
-    m_geomSquare.destroy();
     m_geomGrid.destroy();
+    m_hud.destroy();
+    m_batches.destroy();
+    m_profiler.destroy();
 }
 
 void MyGL::initializeGL()
@@ -54,36 +92,58 @@ void MyGL::initializeGL()
 
     //Create the scene geometry
     m_geomGrid.create();
-    m_geomSquare.create();
-    m_geomTriangle.create();
-
-    // Create and set up the flat lighting shader
-    prog_flat.create(":/glsl/flat.vert.glsl", ":/glsl/flat.frag.glsl");
+    m_hud.create();
+
+    // Create and set up the flat lighting shader.
+    // Read from disk instead of the built-in resources if SCENEGRAPH_SHADER_DIR is set,
+    // in which case saving the files rebuilds the shader while the program runs.
+    m_shaderDir = qEnvironmentVariable("SCENEGRAPH_SHADER_DIR");
+    if (m_shaderDir.isEmpty()) {
+        prog_flat.create(":/glsl/flat.vert.glsl", ":/glsl/flat.frag.glsl");
+    } else {
+        QByteArray vertFile = (m_shaderDir + "/flat.vert.glsl").toLocal8Bit();
+        QByteArray fragFile = (m_shaderDir + "/flat.frag.glsl").toLocal8Bit();
+        prog_flat.create(vertFile.constData(), fragFile.constData());
+        m_shaderWatcher.addPath(QString::fromLocal8Bit(vertFile));
+        m_shaderWatcher.addPath(QString::fromLocal8Bit(fragFile));
+        connect(&m_shaderWatcher, SIGNAL(fileChanged(QString)),
+                this, SLOT(slot_shaderFileChanged(QString)));
+    }
 
     // We have to have a VAO bound in OpenGL 3.2 Core. But if we're not
     // using multiple VAOs, we can just bind one once.
     glBindVertexArray(vao);
 
+    // Pick how the scene graph's draws are submitted
+    m_batches.create();
+    m_profiler.create();
+
     // TODO: Call your scene graph construction function here
     m_rootNode = constructSceneGraph();
+    m_geometry.createPending();
 
     //MyGL emit its signal sig_sendRootNode with the root node of your scene graph as its argument.
+    //Later edits reach the Tree Widget through sig_sceneChanged.
     emit sig_sendRootNode(m_rootNode.get());
 
 }
 
 std::unique_ptr<Node> MyGL::constructSceneGraph(){
+    // Every node drawing the same shape shares one registered Polygon2D
+    Polygon2D* square = m_geometry.polygon(SQUARE_POSITIONS);
+    Polygon2D* triangle = m_geometry.regularPolygon(3);
+
     // A torso that serves as the "root" of all body transformations.
     uPtr translateTorso = mkU<TranslateNode>("TorsoT", 0.0f, 0.0f);
 
     //set color and geometry of torso
     translateTorso->setColor(glm::vec3(0,1,0));
-    translateTorso->setGeometry(&m_geomSquare);
+    translateTorso->setGeometry(square);
 
     //head
     uPtr scaleHead = mkU<ScaleNode>("ScaleHead", 0.75f, 0.75f);
     scaleHead->setColor(glm::vec3(0,0,1));
-    scaleHead->setGeometry(&m_geomSquare);
+    scaleHead->setGeometry(square);
 
     uPtr translateHead = mkU<TranslateNode>("TranslateHead", 0, 1);  // Example translation
 
@@ -98,11 +158,11 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
     // CHILD <- PARENT
     // S <- T <- R
     uPtr scaleLowerArmLeft = mkU<ScaleNode>("ScaleLowerArmLeft", 0.8f, 0.2f);
-    scaleLowerArmLeft->setGeometry(&m_geomSquare);
+    scaleLowerArmLeft->setGeometry(square);
     scaleLowerArmLeft->setColor(glm::vec3(0,0,1));
 
     uPtr scaleLowerArmRight = mkU<ScaleNode>("ScaleLowerArmRight", 0.8f, 0.2f);
-    scaleLowerArmRight->setGeometry(&m_geomSquare);
+    scaleLowerArmRight->setGeometry(square);
     scaleLowerArmRight->setColor(glm::vec3(0,0,1));
 
     //3
@@ -128,11 +188,11 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
     // CHILD <- PARENT
     // S <- T <- R
     uPtr scaleUpperArmLeft = mkU<ScaleNode>("ScaleUpperArmLeft", 0.8f, 0.2f);
-    scaleUpperArmLeft->setGeometry(&m_geomSquare);
+    scaleUpperArmLeft->setGeometry(square);
     scaleUpperArmLeft->setColor(glm::vec3(0.5,0,0.5));
 
     uPtr scaleUpperArmRight = mkU<ScaleNode>("ScaleUpperArmRight", 0.8f, 0.2f);
-    scaleUpperArmRight->setGeometry(&m_geomSquare);
+    scaleUpperArmRight->setGeometry(square);
     scaleUpperArmRight->setColor(glm::vec3(0.5,0,0.5));
 
     //2
@@ -160,11 +220,11 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
 
     //legs
     uPtr scaleLegLeft = mkU<ScaleNode>("ScaleLegLeft", 0.3f, 1.5f);
-    scaleLegLeft->setGeometry(&m_geomSquare);
+    scaleLegLeft->setGeometry(square);
     scaleLegLeft->setColor(glm::vec3(0.0, 0.0, 1.0));
 
     uPtr scaleLegRight = mkU<ScaleNode>("ScaleLegRight", 0.3f, 1.5f);
-    scaleLegRight->setGeometry(&m_geomSquare);
+    scaleLegRight->setGeometry(square);
     scaleLegRight->setColor(glm::vec3(0.0, 0.0, 1.0));
 
     uPtr translateLegLeft = mkU<TranslateNode>("TranslateLegLeft", 0.25f, -1.25f);  // Move to right
@@ -175,7 +235,7 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
 
     //hat
     uPtr scaleHat = mkU<ScaleNode>("ScaleHatNode", 1.0f, 1.0f);
-    scaleHat->setGeometry(&m_geomTriangle);
+    scaleHat->setGeometry(triangle);
     scaleHat->setColor(glm::vec3(1.0, 1.0, 0.0));
 
     uPtr rotateHate = mkU<RotateNode>("RotateHatNode", 90);
@@ -187,14 +247,14 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
     //eyes
     //left eye
     uPtr scaleNodeLeftEye = mkU<ScaleNode>("ScaleEyeLeft", 0.1f, 0.1f);
-    scaleNodeLeftEye->setGeometry(&m_geomSquare);
+    scaleNodeLeftEye->setGeometry(square);
     scaleNodeLeftEye->setColor(glm::vec3(1.0, 1.0, 1.0));
     uPtr translateNodeLeftEye = mkU<TranslateNode>("TranslateEyeLeft", 0.175f, 0.15f);
     translateNodeLeftEye->addChild(std::move(scaleNodeLeftEye));
 
     //right eye
     uPtr scaleNodeRightEye = mkU<ScaleNode>("ScaleEyeRight", 0.1f, 0.1f);
-    scaleNodeRightEye->setGeometry(&m_geomSquare);
+    scaleNodeRightEye->setGeometry(square);
     scaleNodeRightEye->setColor(glm::vec3(1.0,1.0,1.0));
     uPtr translateNodeRightEye = mkU<TranslateNode>("TranslateEyeRight", -0.175f, 0.15f);
     translateNodeRightEye->addChild(std::move(scaleNodeRightEye));
@@ -205,7 +265,7 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
 
     //nose
     uPtr scaleNodeNose = mkU<ScaleNode>("ScaleNose", 0.1f, 0.2f);
-    scaleNodeNose->setGeometry(&m_geomSquare);
+    scaleNodeNose->setGeometry(square);
     scaleNodeNose->setColor(glm::vec3(1.0f,0.71f, 0.75f));
     uPtr translateNodeNose = mkU<TranslateNode>("TranslateNose", 0.0f, 0.09f);
     translateNodeNose->addChild(std::move(scaleNodeNose));
@@ -215,7 +275,7 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
 
     //mouth
     uPtr scaleNodeMouth = mkU<ScaleNode>("ScaleMouth", 0.3f, 0.1f);
-    scaleNodeMouth->setGeometry(&m_geomSquare);
+    scaleNodeMouth->setGeometry(square);
     scaleNodeMouth->setColor(glm::vec3(1.0f,0.0f, 0.0f));
     uPtr translateNodeMouth = mkU<TranslateNode>("TranslateMouth", 0.0f, -0.15f);
     translateNodeMouth->addChild(std::move(scaleNodeMouth));
@@ -233,42 +293,75 @@ std::unique_ptr<Node> MyGL::constructSceneGraph(){
     return translateTorso;
 }
 
+float MyGL::pixelRadius(const Polygon2D& polygon, const glm::mat3& world) const {
+    // Where the polygon's local axes end up in pixels; the longer one bounds the radius
+    glm::mat3 toScreen = m_camera.viewMatrix() * world;
+    glm::vec2 halfViewport = 0.5f * m_camera.viewportSize();
+    float axisX = glm::length(glm::vec2(toScreen[0]) * halfViewport);
+    float axisY = glm::length(glm::vec2(toScreen[1]) * halfViewport);
+    glm::vec2 halfExtent = 0.5f * (polygon.boundsMax() - polygon.boundsMin());
+    return std::max(halfExtent.x * axisX, halfExtent.y * axisY);
+}
+
 //SCENE GRAPH TRAVERSAL
 //function invoked in MyGL::paintG
-void MyGL::sceneGraphTraversal(Node* node, const glm::mat3& transformationMatrix){
+void MyGL::sceneGraphTraversal(Node* node, const glm::mat3& transformationMatrix, bool parentChanged){
     //base case
     if(!node){
         return;
     }
 
-    //combine current transformation with accumulated transformation
-    glm::mat3 currentTransformationMatrix = transformationMatrix * node->computeTransformationMatrix();
+    //a subtree that hasn't moved or changed since its bounds were stored, and whose
+    //bounds are out of view, has nothing to draw and no transformation to update
+    if (!parentChanged && !node->subtreeBoundsDirty() && m_renderQueue.isCulled(node->getSubtreeBounds())) {
+        m_frameStats.subtreesCulled++;
+        return;
+    }
+
+    //combine current transformation with accumulated transformation.
+    //This is only recomputed when the node or one of its ancestors was edited.
+    bool changed = node->updateWorldTransform(transformationMatrix, parentChanged);
+    const glm::mat3& currentTransformationMatrix = node->getWorldTransform();
+    m_frameStats.nodesVisited++;
+    m_frameStats.nodesDirty += changed;
+
+    //box around everything drawn in this subtree, grown below
+    glm::vec4 bounds(INFINITY, INFINITY, -INFINITY, -INFINITY);
 
     //draw polygon
 
     if(node->getPolygon() != nullptr){
+        //circles are drawn with as many sides as their size on screen needs.
+        //The box of the node's polygon holds every level of its LOD chain, so the
+        //subtree bounds stay right when the zoom picks another level.
         Polygon2D * polygon = node->getPolygon();
-        polygon->setColor(node->getColor());
-        prog_flat.setModelMatrix(currentTransformationMatrix);
+        bounds = RenderQueue::worldBox(currentTransformationMatrix, polygon->boundsMin(), polygon->boundsMax());
+        polygon = polygon->lodFor(pixelRadius(*polygon, currentTransformationMatrix));
 //        prog_flat.draw(*this, *(node->getPolygon()));
-        prog_flat.draw(*this, *(polygon));
+        //sorted and submitted together once the traversal is done
+        if (!m_renderQueue.push(*polygon, currentTransformationMatrix, node->getColor(), bounds)) {
+            m_frameStats.nodesCulled++;
+        }
 
     }
 
     //recursively traverse the node's children
     for(const uPtr<Node>& child : node->getChildren()){
         //child.get(): gets raw pointer
-        sceneGraphTraversal(child.get(), currentTransformationMatrix);
+        sceneGraphTraversal(child.get(), currentTransformationMatrix, changed);
+        const glm::vec4& childBounds = child->getSubtreeBounds();
+        bounds = glm::vec4(glm::min(glm::vec2(bounds), glm::vec2(childBounds)),
+                           glm::max(glm::vec2(bounds.z, bounds.w), glm::vec2(childBounds.z, childBounds.w)));
     }
+    node->setSubtreeBounds(bounds);
 }
 
 
 void MyGL::resizeGL(int w, int h)
 {
-    glm::mat3 viewMat = glm::scale(glm::mat3(), glm::vec2(0.2, 0.2)); // Screen is -5 to 5
-
-    // Upload the view matrix to our shader (i.e. onto the graphics card)
-    prog_flat.setViewMatrix(viewMat);
+    // Screen is -5 to 5 vertically, wider or narrower to match the aspect ratio.
+    // paintGL uploads the view matrix now that it changed.
+    m_camera.setViewport(w, h);
 
     printGLErrorLog();
 }
@@ -277,41 +370,263 @@ void MyGL::resizeGL(int w, int h)
 // For example, when the function update() is called, paintGL is called implicitly.
 void MyGL::paintGL()
 {
+    m_profiler.beginFrame();
+    {
+        FrameProfiler::Zone frameZone(m_profiler, "frame");
+        drawFrame();
+    }
+    m_profiler.endFrame();
+
+    // Outside the zones, so the overlay doesn't show up in its own numbers
+    if (m_showHud) {
+        if (++m_framesSinceMemoryReport >= MEMORY_REPORT_INTERVAL) {
+            m_framesSinceMemoryReport = 0;
+            m_memory = MemoryReport();
+            if (m_rootNode) {
+                m_memory.addScene(*m_rootNode);
+            }
+            m_memory.addGeometry(m_geometry);
+            m_memory.addDrawable(m_geomGrid);
+            m_memory.addDrawable(m_hud);
+        }
+        m_hud.update(m_frameStats, m_memory, m_profiler.averages(), m_profiler.frameIntervals());
+        // Positioned in pixels, independent of the camera
+        prog_flat.setViewMatrix(glm::mat3());
+        prog_flat.setModelMatrix(HudOverlay::pixelToNdc(width(), height()));
+        prog_flat.draw(*this, m_hud);
+        prog_flat.setViewMatrix(m_camera.viewMatrix());
+    }
+}
+
+void MyGL::drawFrame()
+{
+    m_frameStats = HudOverlay::Stats();
+    {
+        FrameProfiler::Zone uploadZone(m_profiler, "upload", true);
+
+        // Start / check on a shader rebuild. Neither call waits for the driver
+        // to finish compiling, and the old program is drawn with until then.
+        if (m_shaderReloadReady) {
+            m_shaderReloadReady = false;
+            prog_flat.beginReload(m_pendingVertSource, m_pendingFragSource);
+        }
+        bool viewChanged = m_camera.takeChanged();
+        if (prog_flat.pollReload()) {
+            // uniforms belong to the old program
+            viewChanged = true;
+        }
+        if (viewChanged) {
+            // Upload the view matrix to our shader (i.e. onto the graphics card)
+            prog_flat.setViewMatrix(m_camera.viewMatrix());
+        }
+
+        // Upload shapes registered since the last frame and free the ones no node uses anymore
+        m_geometry.createPending();
+        m_geometry.collectUnused();
+
+        GeometryBuffer& buffer = m_geometry.buffer();
+        m_frameStats.uploadBytes += buffer.takeUploadedBytes();
+        m_frameStats.shapes = m_geometry.size();
+        m_frameStats.vertexCount = buffer.vertexCount();
+        m_frameStats.vertexCapacity = buffer.vertexCapacity();
+        m_frameStats.indexCount = buffer.indexCount();
+        m_frameStats.indexCapacity = buffer.indexCapacity();
+        m_frameStats.freeSpans = buffer.freeSpanCount();
+        m_frameStats.shaderReloadBlocks = !m_shaderDir.isEmpty() && prog_flat.reloadBlocks();
+    }
+
     // Clear the screen so that we only see newly drawn images
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     if (m_showGrid)
     {
+        FrameProfiler::Zone gridZone(m_profiler, "grid", true);
         prog_flat.setModelMatrix(glm::mat3());
         prog_flat.draw(*this, m_geomGrid);
+        m_frameStats.drawCalls++;
     }
 
-    //VVV CLEAR THIS CODE WHEN YOU IMPLEMENT SCENE GRAPH TRAVERSAL VVV///////////////////
+    //calling scene graph traversal and starting at the root node with the identity matrix as the transformation matrix.
+    //This also brings the world transformations of edited nodes up to date.
+    {
+        FrameProfiler::Zone traversalZone(m_profiler, "traversal");
+        m_renderQueue.clear();
+        m_renderQueue.setCullBounds(m_camera.visibleMin(), m_camera.visibleMax());
+        sceneGraphTraversal(m_rootNode.get(), glm::mat3(), false);
+    }
+    {
+        FrameProfiler::Zone sortZone(m_profiler, "sort");
+        m_renderQueue.sort();
+    }
 
-    // Shapes will be drawn on top of one another, so the last object
-    // drawn will appear in front of everything else
+    // Per draw transformations and colors are uploaded along with the draws
+    FrameProfiler::Zone submitZone(m_profiler, "submit", true);
+    for (std::size_t i = 0; i < m_renderQueue.size(); i++) {
+        m_frameStats.triangles += m_renderQueue[i].drawable->elemCount() / 3;
+    }
+    if (m_batches.isSupported()) {
+        m_batches.begin(prog_flat, m_geometry.buffer());
+        for (std::size_t i = 0; i < m_renderQueue.size(); i++) {
+            const RenderQueue::Item& item = m_renderQueue[i];
+            m_batches.add(*item.drawable, item.model, item.color);
+        }
+        m_batches.end();
+        m_frameStats.drawCalls += m_batches.drawCallCount();
+        m_frameStats.uploadBytes += m_batches.uploadedBytes();
+    } else {
+        //every registered polygon lives in the shared buffer
+        prog_flat.beginShared(m_geometry.buffer());
+        for (std::size_t i = 0; i < m_renderQueue.size(); i++) {
+            const RenderQueue::Item& item = m_renderQueue[i];
+            prog_flat.setModelMatrix(item.model);
+            prog_flat.drawShared(*this, *item.drawable, item.color);
+        }
+        prog_flat.endShared();
+        m_frameStats.drawCalls += m_renderQueue.size();
+    }
+}
 
-//    prog_flat.setModelMatrix(glm::mat3());
-//    m_geomSquare.setColor(glm::vec3(0,1,0));
-//    prog_flat.draw(*this, m_geomSquare);
+void MyGL::updateScene()
+{
+    flushPendingEdits();
 
-//    m_geomSquare.setColor(glm::vec3(1,0,0));
-//    prog_flat.setModelMatrix(glm::translate(glm::mat3(), glm::vec2(-1.f, 0.f)) * glm::rotate(glm::mat3(), glm::radians(-30.f)));
-//    prog_flat.draw(*this, m_geomSquare);
+    if (m_shaderFilesChanged) {
+        m_shaderFilesChanged = false;
+        m_pendingVertSource = prog_flat.fileRead((m_shaderDir + "/flat.vert.glsl").toLocal8Bit().constData());
+        m_pendingFragSource = prog_flat.fileRead((m_shaderDir + "/flat.frag.glsl").toLocal8Bit().constData());
+        m_shaderReloadReady = true;
+    }
+}
 
-//    m_geomSquare.setColor(glm::vec3(0,0,1));
-//    prog_flat.setModelMatrix(glm::translate(glm::mat3(), glm::vec2(1.f, 0.f)) * glm::rotate(glm::mat3(), glm::radians(30.f)));
-//    prog_flat.draw(*this, m_geomSquare);
+void MyGL::slot_shaderFileChanged(const QString &path) {
+    // Editors that save by replacing the file make the watcher drop it
+    if (!m_shaderWatcher.files().contains(path)) {
+        m_shaderWatcher.addPath(path);
+    }
+    // Picked up by the next updateScene, so a burst of saves causes one rebuild
+    m_shaderFilesChanged = true;
+}
 
-    //^^^ CLEAR THIS CODE WHEN YOU IMPLEMENT SCENE GRAPH TRAVERSAL ^^^/////////////////
+void MyGL::queueEdit(CommandJournal::Param param, float value)
+{
+    // Only the newest absolute value of a parameter matters, and relative
+    // changes simply add up, so a spin box firing many times between two
+    // frames leaves a single edit
+    if (!m_pendingEdits.empty()) {
+        PendingEdit& last = m_pendingEdits.back();
+        if (last.param == param && last.relative == m_relativeEdits) {
+            last.value = m_relativeEdits ? last.value + value : value;
+            return;
+        }
+    }
+    m_pendingEdits.push_back({param, value, m_relativeEdits});
+}
 
-    // Here is a good spot to call your scene graph traversal function.
+void MyGL::flushPendingEdits()
+{
+    for (const PendingEdit& edit : m_pendingEdits) {
+        // one pass over the selected nodes of the right type
+        const std::vector<Node*>& targets = m_selection.nodesWithParam(edit.param);
+        std::vector<CommandJournal::ParamChange> changes;
+        changes.reserve(targets.size());
+        for (Node* node : targets) {
+            float before = CommandJournal::readParam(node, edit.param);
+            float after = edit.relative ? before + edit.value : edit.value;
+            // marks only this node dirty; its subtree is recomputed in the next traversal
+            CommandJournal::applyParam(node, edit.param, after);
+            changes.push_back({node, before, after});
+        }
+        m_journal.recordParams(edit.param, std::move(changes));
+    }
+    m_pendingEdits.clear();
+}
 
-    //calling scene graph traversal and starting at the root node with the identity matrix as the transformation matrix
-    sceneGraphTraversal(m_rootNode.get(), glm::mat3());
+void MyGL::spinBoxEdit(CommandJournal::Param param, double value)
+{
+    // Relative mode applies how far the spin box moved rather than where it is
+    float& last = m_lastSpinBoxValue[static_cast<int>(param)];
+    float delta = static_cast<float>(value) - last;
+    last = static_cast<float>(value);
 
-    // Any time you want to draw an instance of geometry, call
-    // prog_flat.draw(*this, yourNonPointerGeometry);
+    if (m_selection.nodesWithParam(param).empty()) {
+        return;
+    }
+    queueEdit(param, m_relativeEdits ? delta : static_cast<float>(value));
+}
+
+Node* MyGL::pickNode(int x, int y)
+{
+    if (!m_rootNode || width() <= 0 || height() <= 0) {
+        return nullptr;
+    }
+    glm::vec3 scenePos(m_camera.pixelToScene(glm::vec2(x, y)), 1.f);
+
+    // Later nodes are drawn on top, so the last hit in traversal order wins.
+    // Uses the world transformations cached by the last paintGL.
+    Node* hit = nullptr;
+    std::vector<Node*> stack = {m_rootNode.get()};
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        const glm::mat3& world = node->getWorldTransform();
+        Polygon2D* polygon = node->getPolygon();
+        if (polygon && std::abs(glm::determinant(world)) > 1e-8f) {
+            glm::vec2 local(glm::inverse(world) * scenePos);
+            if (glm::all(glm::greaterThanEqual(local, polygon->boundsMin()))
+                    && glm::all(glm::lessThanEqual(local, polygon->boundsMax()))) {
+                hit = node;
+            }
+        }
+        Node::ChildList& children = node->getChildren();
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            stack.push_back(it->get());
+        }
+    }
+    return hit;
+}
+
+void MyGL::mousePressEvent(QMouseEvent *e)
+{
+    if (e->button() == Qt::RightButton || e->button() == Qt::MiddleButton) {
+        m_panning = true;
+        m_lastMousePos = e->pos();
+        return;
+    }
+    if (e->button() != Qt::LeftButton) {
+        return;
+    }
+    Node* hit = pickNode(e->pos().x(), e->pos().y());
+    bool additive = e->modifiers() & Qt::ControlModifier;
+    if (hit) {
+        mp_selectedNode = hit;
+    }
+    // MainWindow selects the item in the Tree Widget, which then
+    // reports the whole selection back through slot_setSelectedNodes
+    emit sig_pickNode(hit, additive);
+}
+
+void MyGL::mouseMoveEvent(QMouseEvent *e)
+{
+    if (m_panning) {
+        QPoint delta = e->pos() - m_lastMousePos;
+        m_camera.pan(glm::vec2(delta.x(), delta.y()));
+        m_lastMousePos = e->pos();
+    }
+}
+
+void MyGL::mouseReleaseEvent(QMouseEvent *e)
+{
+    if (e->button() == Qt::RightButton || e->button() == Qt::MiddleButton) {
+        m_panning = false;
+    }
+}
+
+void MyGL::wheelEvent(QWheelEvent *e)
+{
+    // One notch is reported as 120
+    float notches = e->angleDelta().y() / 120.f;
+    m_camera.zoomAt(std::pow(WHEEL_ZOOM_PER_NOTCH, notches),
+                    glm::vec2(e->position().x(), e->position().y()));
 }
 
 void MyGL::keyPressEvent(QKeyEvent *e)
@@ -326,74 +641,70 @@ void MyGL::keyPressEvent(QKeyEvent *e)
     case(Qt::Key_G):
         m_showGrid = !m_showGrid;
         break;
+
+    case(Qt::Key_H):
+        m_showHud = !m_showHud;
+        // Measure memory on the first frame shown
+        m_framesSinceMemoryReport = MEMORY_REPORT_INTERVAL;
+        break;
+
+    case(Qt::Key_Home):
+        m_camera.reset();
+        break;
+
+    case(Qt::Key_T):
+        // Open in chrome://tracing or ui.perfetto.dev
+        if (m_profiler.writeTrace(TRACE_FILE)) {
+            qDebug() << "Wrote the last frames' timings to" << TRACE_FILE;
+        } else {
+            qDebug() << "Could not write" << TRACE_FILE;
+        }
+        break;
     }
 }
 
-void MyGL::slot_setSelectedNode(QTreeWidgetItem *i) {
-    mp_selectedNode = static_cast<Node*>(i);
+void MyGL::slot_setSelectedNode(Node *n) {
+    mp_selectedNode = n;
+}
+
+void MyGL::slot_setSelectedNodes(const std::vector<Node*>& nodes) {
+    // queued edits were meant for the old selection
+    flushPendingEdits();
+    m_selection.set(nodes);
+}
+
+void MyGL::slot_setRelativeEdits(bool relative) {
+    flushPendingEdits();
+    m_relativeEdits = relative;
 }
 
 //SLOT FOR TRANSLATING X
+//Edits every selected TranslateNode
 void MyGL::slot_setTX(double x) {
-    // TODO update the currently selected Node's
-    // X translation value IF AND ONLY IF
-    // the currently selected node can be validly
-    // dynamic_cast to a TranslateNode.
-    // Remember that a failed dynamic_cast
-    // will return a null pointer.
-
-    //return if no node is selected
-    if(!mp_selectedNode){
-        return;
-    }
-    TranslateNode *tn = dynamic_cast<TranslateNode*>(mp_selectedNode);
-    //check if dynamic cast was successful
-    if (tn) {
-        tn->setTX(static_cast<float>(x));
-    }
+    spinBoxEdit(CommandJournal::Param::TX, x);
 }
 
 void MyGL::slot_setTY(double Y){
-    if(!mp_selectedNode){
-        return;
-    }
-    TranslateNode *tn = dynamic_cast<TranslateNode*>(mp_selectedNode);
-    if (tn) {
-        tn->setTY(static_cast<float>(Y));
-    }
+    spinBoxEdit(CommandJournal::Param::TY, Y);
 }
 
 //rotate
 void MyGL::slot_setRotate(double angle){
-    if(!mp_selectedNode){
-        return;
-    }
-    RotateNode *rn = dynamic_cast<RotateNode*>(mp_selectedNode);
-    if (rn) {
-        rn->setRotate(static_cast<float>(angle));
-    }
-
+    spinBoxEdit(CommandJournal::Param::Rotate, angle);
 }
 
 //scale
 void MyGL::slot_setScaleX(double sx){
-    if(!mp_selectedNode){
-        return;
-    }
-    ScaleNode *sn = dynamic_cast<ScaleNode*>(mp_selectedNode);
-    if (sn) {
-        sn->setSX(static_cast<float>(sx));
-    }
+    spinBoxEdit(CommandJournal::Param::SX, sx);
 }
 
 void MyGL::slot_setScaleY(double sy){
-    if(!mp_selectedNode){
-        return;
-    }
-    ScaleNode *sn = dynamic_cast<ScaleNode*>(mp_selectedNode);
-    if (sn) {
-        sn->setSY(static_cast<float>(sy));
-    }
+    spinBoxEdit(CommandJournal::Param::SY, sy);
+}
+
+void MyGL::slot_finishEdit() {
+    flushPendingEdits();
+    m_journal.endInteraction();
 }
 
 void MyGL::slot_addTranslateNode() {
@@ -404,24 +715,30 @@ void MyGL::slot_addTranslateNode() {
     if(!mp_selectedNode){
         return;
     }
+    flushPendingEdits();
     uPtr newTranslateNode = mkU<TranslateNode>("newTranslateNode", 0.0f, 0.0f);
-    mp_selectedNode->addChild(std::move(newTranslateNode));
+    Node& child = mp_selectedNode->addChild(std::move(newTranslateNode), &m_sceneChanges);
+    m_journal.recordAddChild(mp_selectedNode, &child);
 }
 
 void MyGL::slot_addRotateNode(){
     if(!mp_selectedNode){
         return;
     }
+    flushPendingEdits();
     uPtr newRotateNode = mkU<RotateNode>("newRotateNode", 0.0f);
-    mp_selectedNode->addChild(std::move(newRotateNode));
+    Node& child = mp_selectedNode->addChild(std::move(newRotateNode), &m_sceneChanges);
+    m_journal.recordAddChild(mp_selectedNode, &child);
 }
 
 void MyGL::slot_addScaleNode(){
     if(!mp_selectedNode){
         return;
     }
+    flushPendingEdits();
     uPtr newScaleNode = mkU<ScaleNode>("newScaleNode", 0.0f, 0.0f);
-    mp_selectedNode->addChild(std::move(newScaleNode));
+    Node& child = mp_selectedNode->addChild(std::move(newScaleNode), &m_sceneChanges);
+    m_journal.recordAddChild(mp_selectedNode, &child);
 }
 
 void MyGL::enableWidgetsBasedOnSelectedNode(){
@@ -430,9 +747,68 @@ void MyGL::enableWidgetsBasedOnSelectedNode(){
 
 
 void MyGL::slot_setPolygon2DPointerToSquare() {
+    setSelectedGeometry(m_geometry.polygon(SQUARE_POSITIONS));
+}
+
+void MyGL::slot_setGeometrySides(int numSides) {
+    m_geometrySides = numSides;
+}
+
+void MyGL::slot_setGeometry() {
+    // 4 sides gives the axis-aligned square rather than a diamond
+    if (m_geometrySides == 4) {
+        slot_setPolygon2DPointerToSquare();
+    } else {
+        setSelectedGeometry(m_geometry.regularPolygon(m_geometrySides));
+    }
+}
+
+void MyGL::setSelectedGeometry(Polygon2D* geometry) {
     //check for nullptr
     if (mp_selectedNode) {
-        mp_selectedNode->setGeometry(&m_geomSquare);
+        flushPendingEdits();
+        Polygon2D* before = mp_selectedNode->getPolygon();
+        mp_selectedNode->setGeometry(geometry);
+        m_journal.recordGeometry(mp_selectedNode, before, geometry);
+    }
+}
+
+
+void MyGL::slot_duplicateSelectedNode() {
+    if (!mp_selectedNode) {
+        return;
+    }
+    // the root has no parent to hold a sibling copy
+    Node* parent = mp_selectedNode->getParent();
+    if (!parent) {
+        return;
     }
+    flushPendingEdits();
+    Node& copy = parent->addChild(mp_selectedNode->cloneSubtree(), &m_sceneChanges);
+    m_journal.recordAddChild(parent, &copy);
 }
 
+void MyGL::slot_undo() {
+    // queued edits happened before the undo request, so they have to be in the history first
+    flushPendingEdits();
+    m_journal.undo();
+    deselectIfDetached();
+}
+
+void MyGL::slot_redo() {
+    flushPendingEdits();
+    m_journal.redo();
+    deselectIfDetached();
+}
+
+void MyGL::deselectIfDetached() {
+    // Undoing an added node takes it out of the scene graph; don't keep editing it
+    Node* node = mp_selectedNode;
+    while (node && node->getParent()) {
+        node = node->getParent();
+    }
+    if (node != m_rootNode.get()) {
+        mp_selectedNode = nullptr;
+    }
+    m_selection.removeDetached(m_rootNode.get());
+}
@@ -4,11 +4,20 @@
 #include <shaderprogram.h>
 #include <scene/grid.h>
 #include <scene/polygon.h>
-#include <QTreeWidgetItem>
+#include <scene/geometryregistry.h>
+#include <QFileSystemWatcher>
 
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLShaderProgram>
 #include "scene/node.h"
+#include "commandjournal.h"
+#include "nodeselection.h"
+#include "batchrenderer.h"
+#include "renderqueue.h"
+#include "camera.h"
+#include "frameprofiler.h"
+#include "hudoverlay.h"
+#include <array>
 
 
 class MyGL
@@ -19,21 +28,77 @@ private:
     ShaderProgram prog_flat;// A shader program that uses "flat" reflection (no shadowing at all)
 
     Grid m_geomGrid; // The instance of the object used to render the 5x5 grid
-    Polygon2D m_geomSquare; // The singular instance of our square object that can be re-drawn with different colors
-                         // to create the appearance of there being multiple squares
+    GeometryRegistry m_geometry; // Every Polygon2D the scene graph can draw. Nodes using the same shape
+                                 // share one instance that is re-drawn with different colors.
+                                 // Declared before m_rootNode so it outlives the Nodes pointing into it.
 
-    //
-    Polygon2D m_geomTriangle;
-    //
+    RenderQueue m_renderQueue; // The traversal's draws, reordered to group same-geometry draws where they don't overlap
+    BatchRenderer m_batches; // Submits the sorted draws in one go
+    FrameProfiler m_profiler; // Times the stages of paintGL on the CPU and the GPU
 
     bool m_showGrid; // Read in paintGL to determine whether or not to draw the grid.
 
+    HudOverlay m_hud; // Frame timings and counters drawn over the scene
+    bool m_showHud; // Toggled with the H key
+    HudOverlay::Stats m_frameStats; // Counted by drawFrame and sceneGraphTraversal for m_hud
+    MemoryReport m_memory; // Shown by m_hud. Walking the whole scene takes a while, so it is refreshed now and then.
+    int m_framesSinceMemoryReport;
+
     GLuint vao; // A handle for our vertex array object. This will store the VBOs created in our geometry classes.
 
-    Node *mp_selectedNode; // A pointer to the Node that was last clicked on in the GUI's Tree Widget
+    Node *mp_selectedNode; // A pointer to the Node that was last clicked on in the GUI's Tree Widget or viewport.
+                           // Structural edits (adding / duplicating nodes) apply to this node only.
 
+    SceneChangeLog m_sceneChanges; // Structural edits of the scene graph not yet sent to the Tree Widget.
+                                   // Passed to every structural edit made by MyGL and m_journal.
     uPtr<Node> m_rootNode; //root node of the Scene Graph
 
+    CommandJournal m_journal; // History of edits made through the GUI, for undo / redo
+
+    // Clears mp_selectedNode if it is no longer part of the scene graph
+    void deselectIfDetached();
+
+    NodeSelection m_selection; // Every Node selected in the Tree Widget or the viewport
+    bool m_relativeEdits; // If true, spin box changes are added to the selected nodes' values instead of replacing them
+    std::array<float, 5> m_lastSpinBoxValue; // Last value of each spin box, indexed by CommandJournal::Param
+
+    Camera m_camera; // Pans and zooms the view; its matrix is uploaded in paintGL whenever it changed
+    bool m_panning; // True while the right or middle mouse button drags the view
+    QPoint m_lastMousePos; // Where the last mouse event of a drag happened
+
+    // How many pixels the given polygon spans from its center when drawn with the given world transformation
+    float pixelRadius(const Polygon2D& polygon, const glm::mat3& world) const;
+
+    int m_geometrySides; // Number of sides of the polygon that slot_setGeometry assigns
+
+    // Gives the selected Node the given geometry, recording the change for undo
+    void setSelectedGeometry(Polygon2D* geometry);
+
+    QString m_shaderDir; // Directory prog_flat's source files are read from, or empty to use the built-in resources
+    QFileSystemWatcher m_shaderWatcher; // Watches the files in m_shaderDir for changes
+    bool m_shaderFilesChanged; // Set when a watched file changed; read again in updateScene
+    QByteArray m_pendingVertSource; // Shader text read in updateScene, waiting for paintGL to compile it
+    QByteArray m_pendingFragSource;
+    bool m_shaderReloadReady;
+
+    // A transformation edit from the GUI waiting to be applied to the selection at the next frame
+    struct PendingEdit {
+        CommandJournal::Param param;
+        float value;
+        bool relative;
+    };
+    std::vector<PendingEdit> m_pendingEdits;
+
+    // Queues an edit of the selection, merging it into the last queued edit if that was of the same parameter
+    void queueEdit(CommandJournal::Param param, float value);
+    // Applies and records every queued edit in one batch
+    void flushPendingEdits();
+    // Shared body of the spin box slots
+    void spinBoxEdit(CommandJournal::Param param, double value);
+
+    // Returns the topmost Node whose geometry covers the given widget pixel, or nullptr
+    Node* pickNode(int x, int y);
+
 public:
     explicit MyGL(QWidget *parent = 0);
     ~MyGL();
@@ -41,24 +106,49 @@ public:
     void initializeGL();
     void resizeGL(int w, int h);
     void paintGL();
+    // The body of paintGL, with every stage in a profiler zone
+    void drawFrame();
 
     // construct scene graph
     std::unique_ptr<Node> constructSceneGraph();
 
-    //scene graph traversal
-    void sceneGraphTraversal(Node* Node, const glm::mat3& transformationMatrix);
+    //scene graph traversal. parentChanged tells whether the parent's world transformation
+    //was recomputed this frame, in which case node's must be too.
+    //Draws are recorded in m_renderQueue rather than issued directly.
+    void sceneGraphTraversal(Node* Node, const glm::mat3& transformationMatrix, bool parentChanged);
 
 protected:
     void keyPressEvent(QKeyEvent *e);
+    // Applies the edits queued by the spin box slots, once per frame
+    void updateScene() override;
+    // Selects the Node under the cursor; Ctrl adds it to / removes it from the selection.
+    // The right or middle button starts panning the view instead.
+    void mousePressEvent(QMouseEvent *e);
+    void mouseMoveEvent(QMouseEvent *e);
+    void mouseReleaseEvent(QMouseEvent *e);
+    // Zooms the view in / out around the cursor
+    void wheelEvent(QWheelEvent *e);
 
 signals:
-    void sig_sendRootNode(QTreeWidgetItem*);
+    void sig_sendRootNode(Node*);
+    // The scene graph's structural edits since the last batch, sent once per
+    // event loop iteration in which there were any
+    void sig_sceneChanged(const SceneChangeBatch&);
+    // Emitted when a Node is clicked in the viewport (nullptr if empty space was clicked)
+    void sig_pickNode(Node*, bool additive);
 
 public slots:
     // Assigns mp_selectedNode to the input pointer.
-    // Is connected to a signal from the Tree Widget in the GUI
+    // Is connected (through MainWindow) to a signal from the Tree Widget in the GUI
     // that is emitted every time an element in the widget is clicked.
-    void slot_setSelectedNode(QTreeWidgetItem*);
+    void slot_setSelectedNode(Node*);
+
+    // Replaces the set of Nodes that the transformation spin boxes edit.
+    // Connected to the Tree Widget's selection.
+    void slot_setSelectedNodes(const std::vector<Node*>&);
+
+    // Switches the spin boxes between setting values and offsetting them
+    void slot_setRelativeEdits(bool);
 
     // TODO: Add slots for altering the currently selected Node's
     // translate / rotate / scale value(s). We have provided
@@ -77,6 +167,10 @@ public slots:
 
     void slot_setScaleY(double sy);
 
+    // A spin box finished editing (Enter or losing focus): its changes so far
+    // become one undo entry, and the next change starts another
+    void slot_finishEdit();
+
     // TODO: Add slots to add a new Translate / Rotate / Scale Node
     // as a child to the currently selected Node. We have provided
     // an example for adding a Translate Node.
@@ -87,10 +181,26 @@ public slots:
     void slot_addScaleNode();
 
     // TODO: Add a slot to set the Polygon2D pointer of the currently
-    // selected Node to the provided m_geomSquare
+    // selected Node to the square
 
     void slot_setPolygon2DPointerToSquare();
 
+    // Sets the selected Node's geometry to a regular polygon with the
+    // number of sides chosen through slot_setGeometrySides (4 = square)
+    void slot_setGeometry();
+    void slot_setGeometrySides(int numSides);
+
+    // Deep-copies the currently selected Node's subtree and adds the copy
+    // as a sibling of the selected Node
+    void slot_duplicateSelectedNode();
+
+    // Schedules prog_flat to be rebuilt from the changed file
+    void slot_shaderFileChanged(const QString &path);
+
+    // Undo / redo the most recent edit recorded in m_journal
+    void slot_undo();
+    void slot_redo();
+
     // extra credit: enable widgets dependent on type of node
     void enableWidgetsBasedOnSelectedNode();
 };
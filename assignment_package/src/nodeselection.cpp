@@ -0,0 +1,77 @@
+#include "nodeselection.h"
+#include <algorithm>
+
+NodeSelection::NodeSelection()
+    : m_nodes(), m_translateNodes(), m_rotateNodes(), m_scaleNodes()
+{}
+
+void NodeSelection::set(const std::vector<Node*>& nodes)
+{
+    m_nodes = nodes;
+    sortByType();
+}
+
+void NodeSelection::clear()
+{
+    m_nodes.clear();
+    sortByType();
+}
+
+void NodeSelection::removeDetached(const Node* root)
+{
+    auto detached = [root](const Node* n) {
+        while (n->getParent()) {
+            n = n->getParent();
+        }
+        return n != root;
+    };
+    m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(), detached), m_nodes.end());
+    sortByType();
+}
+
+const std::vector<Node*>& NodeSelection::nodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<Node*>& NodeSelection::nodesWithParam(CommandJournal::Param param) const
+{
+    switch (param) {
+    case CommandJournal::Param::TX:
+    case CommandJournal::Param::TY:
+        return m_translateNodes;
+    case CommandJournal::Param::Rotate:
+        return m_rotateNodes;
+    case CommandJournal::Param::SX:
+    case CommandJournal::Param::SY:
+        break;
+    }
+    return m_scaleNodes;
+}
+
+bool NodeSelection::empty() const
+{
+    return m_nodes.empty();
+}
+
+void NodeSelection::sortByType()
+{
+    m_translateNodes.clear();
+    m_rotateNodes.clear();
+    m_scaleNodes.clear();
+    for (Node* n : m_nodes) {
+        switch (n->getType()) {
+        case NodeType::Translate:
+            m_translateNodes.push_back(n);
+            break;
+        case NodeType::Rotate:
+            m_rotateNodes.push_back(n);
+            break;
+        case NodeType::Scale:
+            m_scaleNodes.push_back(n);
+            break;
+        case NodeType::Plain:
+            break;
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include "scene/node.h"
+#include "commandjournal.h"
+
+// The set of Nodes currently selected in the GUI.
+// The nodes are sorted into one list per node type whenever the selection
+// changes, so an edit of e.g. a rotation only ever visits the selected RotateNodes.
+class NodeSelection
+{
+public:
+    NodeSelection();
+
+    // Replaces the selection with the given nodes
+    void set(const std::vector<Node*>& nodes);
+    void clear();
+    // Drops every selected node that can no longer be reached from root
+    void removeDetached(const Node* root);
+
+    // Every selected node, in selection order
+    const std::vector<Node*>& nodes() const;
+    // The selected nodes that have the given transformation parameter
+    const std::vector<Node*>& nodesWithParam(CommandJournal::Param param) const;
+    bool empty() const;
+
+private:
+    // Rebuilds the per-type lists from m_nodes
+    void sortByType();
+
+    std::vector<Node*> m_nodes;
+    std::vector<Node*> m_translateNodes;
+    std::vector<Node*> m_rotateNodes;
+    std::vector<Node*> m_scaleNodes;
+};
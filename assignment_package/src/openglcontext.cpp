@@ -174,5 +174,9 @@ void OpenGLContext::timerUpdate()
     // (Don't update your scene in paintGL, because it
     // sometimes gets called automatically by Qt.)
 
+    updateScene();
     update();
 }
+
+void OpenGLContext::updateScene()
+{}
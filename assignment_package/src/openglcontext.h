@@ -20,6 +20,11 @@ protected:
     /*** If true, save a test image and exit */
     /***/ bool autotesting;
 
+    /// Called once per timer tick, before the redraw is requested.
+    /// Subclasses apply their per-frame scene updates here so that
+    /// nothing changes while paintGL is running.
+    virtual void updateScene();
+
 public:
     OpenGLContext(QWidget *parent);
     ~OpenGLContext();
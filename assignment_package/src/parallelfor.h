@@ -0,0 +1,39 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// The number of threads to use when threadCount were asked for: threadCount itself,
+// or one per hardware thread for 0
+inline unsigned int resolveThreadCount(unsigned int threadCount)
+{
+    return threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Calls body(i) for every i in [0, count) on up to threadCount threads, the calling
+// thread being one of them, and returns once every call has. Indices are handed out
+// one at a time, so threads that get cheap ones take more of them. body must be safe
+// to call from several threads at once for different indices.
+template<typename Body>
+void parallelFor(int count, unsigned int threadCount, const Body& body)
+{
+    std::atomic<int> next(0);
+    auto work = [&next, &body, count]() {
+        for (int i = next++; i < count; i = next++) {
+            body(i);
+        }
+    };
+
+    unsigned int workers = std::min(std::max(threadCount, 1u), unsigned(std::max(count, 1)));
+    std::vector<std::thread> threads;
+    threads.reserve(workers - 1);
+    for (unsigned int i = 1; i < workers; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
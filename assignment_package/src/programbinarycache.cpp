@@ -0,0 +1,133 @@
+#include "programbinarycache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QOpenGLContext>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <cstring>
+
+// From ARB_get_program_binary, in case the GL headers predate it
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+ProgramBinaryCache::ProgramBinaryCache(OpenGLContext* context)
+    : mp_context(context),
+      m_getProgramBinary(nullptr), m_programBinary(nullptr), m_programParameteri(nullptr),
+      m_dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shaders")
+{
+    if (qEnvironmentVariableIsSet("SCENEGRAPH_NO_SHADER_CACHE")) {
+        return;
+    }
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    if (!ctx) {
+        return;
+    }
+    QSurfaceFormat form = ctx->format();
+    bool core41 = form.majorVersion() > 4 || (form.majorVersion() == 4 && form.minorVersion() >= 1);
+    if (!core41 && !ctx->hasExtension("GL_ARB_get_program_binary")) {
+        return;
+    }
+    // Some drivers expose the functions but support no binary formats at all
+    GLint numFormats = 0;
+    mp_context->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats <= 0) {
+        return;
+    }
+    m_getProgramBinary = reinterpret_cast<GetProgramBinaryFn>(ctx->getProcAddress("glGetProgramBinary"));
+    m_programBinary = reinterpret_cast<ProgramBinaryFn>(ctx->getProcAddress("glProgramBinary"));
+    m_programParameteri = reinterpret_cast<ProgramParameteriFn>(ctx->getProcAddress("glProgramParameteri"));
+}
+
+bool ProgramBinaryCache::isSupported() const
+{
+    return m_getProgramBinary && m_programBinary && m_programParameteri;
+}
+
+QByteArray ProgramBinaryCache::key(const QByteArray& vertSource, const QByteArray& fragSource) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    // Each source's length goes before it, so no two ways of splitting the same text share a key
+    for (const QByteArray* source : {&vertSource, &fragSource}) {
+        qint64 length = source->size();
+        hash.addData(reinterpret_cast<const char*>(&length), sizeof(length));
+        hash.addData(*source);
+    }
+    // A binary is only valid for the driver that produced it
+    for (GLenum e : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        hash.addData(QByteArray(reinterpret_cast<const char*>(mp_context->glGetString(e))));
+    }
+    return hash.result().toHex();
+}
+
+void ProgramBinaryCache::prepareForSave(GLuint prog)
+{
+    if (isSupported()) {
+        m_programParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+bool ProgramBinaryCache::load(const QByteArray& key, GLuint prog)
+{
+    if (!isSupported()) {
+        return false;
+    }
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // File layout: the GLenum binary format, followed by the binary itself
+    QByteArray data = file.readAll();
+    file.close();
+    if (data.size() <= static_cast<int>(sizeof(GLenum))) {
+        return false;
+    }
+    GLenum format;
+    std::memcpy(&format, data.constData(), sizeof(GLenum));
+    m_programBinary(prog, format, data.constData() + sizeof(GLenum), data.size() - sizeof(GLenum));
+
+    GLint linked = GL_FALSE;
+    mp_context->glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        // e.g. the driver changed its binary format without changing its version string
+        QFile::remove(filePath(key));
+        return false;
+    }
+    return true;
+}
+
+void ProgramBinaryCache::save(const QByteArray& key, GLuint prog)
+{
+    if (!isSupported()) {
+        return;
+    }
+    GLint length = 0;
+    mp_context->glGetProgramiv(prog, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    QByteArray data(sizeof(GLenum) + length, '\0');
+    GLenum format = 0;
+    m_getProgramBinary(prog, length, nullptr, &format, data.data() + sizeof(GLenum));
+    std::memcpy(data.data(), &format, sizeof(GLenum));
+
+    // Written to a temporary file first so a crash can't leave a truncated entry
+    QDir().mkpath(m_dir);
+    QSaveFile file(filePath(key));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.commit();
+    }
+}
+
+QString ProgramBinaryCache::filePath(const QByteArray& key) const
+{
+    return m_dir + "/" + QString::fromLatin1(key) + ".bin";
+}
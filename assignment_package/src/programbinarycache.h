@@ -0,0 +1,42 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <QByteArray>
+#include <QString>
+
+// Stores linked shader programs on disk (glGetProgramBinary) so that later
+// launches can load them with glProgramBinary instead of compiling and linking.
+// Entries are keyed by a hash of the shader sources and the driver strings,
+// so editing a shader or updating the driver simply misses the cache.
+// Needs OpenGL 4.1 or ARB_get_program_binary; without it every load misses.
+class ProgramBinaryCache
+{
+public:
+    ProgramBinaryCache(OpenGLContext* context);
+
+    // True if the driver can save and load program binaries and caching
+    // wasn't turned off with the SCENEGRAPH_NO_SHADER_CACHE environment variable
+    bool isSupported() const;
+    // The cache key of a program linked from the given sources on the current driver
+    QByteArray key(const QByteArray& vertSource, const QByteArray& fragSource) const;
+    // Must be called before prog is linked so that save() can read its binary back
+    void prepareForSave(GLuint prog);
+    // Loads the binary stored under key into prog. Returns true if prog is now linked.
+    bool load(const QByteArray& key, GLuint prog);
+    // Stores the binary of the linked program prog under key
+    void save(const QByteArray& key, GLuint prog);
+
+private:
+    typedef void (QOPENGLF_APIENTRYP GetProgramBinaryFn)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    typedef void (QOPENGLF_APIENTRYP ProgramBinaryFn)(GLuint, GLenum, const void*, GLsizei);
+    typedef void (QOPENGLF_APIENTRYP ProgramParameteriFn)(GLuint, GLenum, GLint);
+
+    // Where the binary for key is stored
+    QString filePath(const QByteArray& key) const;
+
+    OpenGLContext* mp_context;
+    GetProgramBinaryFn m_getProgramBinary;
+    ProgramBinaryFn m_programBinary;
+    ProgramParameteriFn m_programParameteri;
+    QString m_dir; // Directory holding one file per cached program
+};
@@ -0,0 +1,45 @@
+#include "renderbackend.h"
+#include "scene/node.h"
+#include "scene/grid.h"
+
+RenderBackend::~RenderBackend() = default;
+
+void RenderBackend::drawScene(Node& root)
+{
+    // Same order as MyGL::sceneGraphTraversal, without recursing.
+    // Each entry is (node, its parent's world transformation, whether that changed).
+    struct Entry {
+        Node* node;
+        glm::mat3 parentWorld;
+        bool parentChanged;
+    };
+    std::vector<Entry> stack;
+    stack.push_back({&root, glm::mat3(1.f), false});
+
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
+        Node* node = entry.node;
+
+        bool changed = node->updateWorldTransform(entry.parentWorld, entry.parentChanged);
+        const glm::mat3& world = node->getWorldTransform();
+
+        if (Polygon2D* polygon = node->getPolygon()) {
+            drawTriangles(polygon->positions(), polygon->indices(), world, node->getColor());
+        }
+
+        // Pushed in reverse so the first child is drawn first
+        Node::ChildList& children = node->getChildren();
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            stack.push_back({it->get(), world, changed});
+        }
+    }
+}
+
+void RenderBackend::drawGrid()
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    Grid::vertices(positions, colors);
+    drawLines(positions, colors, glm::mat3(1.f));
+}
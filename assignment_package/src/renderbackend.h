@@ -0,0 +1,36 @@
+#pragma once
+
+#include <la.h>
+#include <cstdint>
+#include <vector>
+
+class Node;
+
+// Something that can draw the flat-colored triangles and lines a scene is made of.
+// MyGL draws through OpenGL directly; SoftwareRasterizer implements this on the CPU
+// so that scenes can be rendered without a GPU or a window.
+// Draws are layered in the order they are made: later ones cover earlier ones.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend();
+
+    // Starts a width x height image filled with clearColor. view maps scene
+    // coordinates to normalized device coordinates, like ShaderProgram's u_View.
+    virtual void beginFrame(int width, int height, const glm::mat3& view, const glm::vec3& clearColor) = 0;
+    // Draws the triangles indexed by indices (three per triangle) in one color
+    virtual void drawTriangles(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices,
+                               const glm::mat3& model, const glm::vec3& color) = 0;
+    // Draws one-pixel-wide line segments between each pair of positions,
+    // colored by the first vertex of the pair
+    virtual void drawLines(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& colors,
+                           const glm::mat3& model) = 0;
+    // Finishes every draw of the frame
+    virtual void endFrame() = 0;
+
+    // Draws every polygon of the scene graph under root, parents before children.
+    // The polygons' positions and indices must still be on the CPU, i.e. they were never create()d.
+    void drawScene(Node& root);
+    // Draws the same lines as Grid
+    void drawGrid();
+};
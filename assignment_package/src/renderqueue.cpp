@@ -0,0 +1,201 @@
+#include "renderqueue.h"
+#include <algorithm>
+#include <cmath>
+
+// Layout of the sort key, from the most significant bits down
+const static int LEVEL_BITS = 24;
+const static int SHADER_BITS = 8;
+const static int GEOMETRY_BITS = 24;
+const static int GEOMETRY_SHIFT = 0;
+const static int SHADER_SHIFT = GEOMETRY_SHIFT + GEOMETRY_BITS;
+const static int LEVEL_SHIFT = SHADER_SHIFT + SHADER_BITS;
+const static int LAYER_SHIFT = LEVEL_SHIFT + LEVEL_BITS;
+
+// The grid computeLevels buckets boxes into has at most this many cells per side
+const static int MAX_GRID_SIZE = 64;
+
+RenderQueue::RenderQueue()
+    : m_items(), m_bounds(), m_levels(), m_keys(), m_order(),
+      m_cullBounds(-INFINITY, -INFINITY, INFINITY, INFINITY),
+      m_layerGrids(),
+      mp_lastDrawable(nullptr), m_lastGeometryId(0), m_geometries()
+{}
+
+void RenderQueue::clear()
+{
+    // clear() keeps the capacity, so steady frames don't reallocate
+    m_items.clear();
+    m_bounds.clear();
+    m_keys.clear();
+    m_order.clear();
+    m_geometries.clear();
+    mp_lastDrawable = nullptr;
+}
+
+void RenderQueue::setCullBounds(const glm::vec2& min, const glm::vec2& max)
+{
+    m_cullBounds = glm::vec4(min, max);
+}
+
+bool RenderQueue::isCulled(const glm::vec4& box) const
+{
+    return box.z < m_cullBounds.x || box.w < m_cullBounds.y || box.x > m_cullBounds.z || box.y > m_cullBounds.w;
+}
+
+glm::vec4 RenderQueue::worldBox(const glm::mat3& model, const glm::vec2& boundsMin, const glm::vec2& boundsMax)
+{
+    // The box around the transformed corners contains the transformed shape
+    glm::vec2 lo(INFINITY), hi(-INFINITY);
+    for (const glm::vec2& corner : {boundsMin, boundsMax, glm::vec2(boundsMin.x, boundsMax.y),
+                                    glm::vec2(boundsMax.x, boundsMin.y)}) {
+        glm::vec2 p(model * glm::vec3(corner, 1.f));
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    return glm::vec4(lo, hi);
+}
+
+bool RenderQueue::push(Drawable& d, const glm::mat3& model, const glm::vec3& color,
+                       const glm::vec4& box, std::uint8_t layer, std::uint8_t shader)
+{
+    if (isCulled(box)) {
+        return false;
+    }
+    m_items.push_back({&d, model, color});
+    m_bounds.push_back(box);
+
+    // Dense ids keep the geometry field small; shapes usually repeat in runs
+    if (&d != mp_lastDrawable) {
+        m_lastGeometryId = m_geometries.emplace(&d, std::uint32_t(m_geometries.size())).first->second;
+        mp_lastDrawable = &d;
+    }
+    std::uint64_t geometry = std::min<std::uint32_t>(m_lastGeometryId, (1u << GEOMETRY_BITS) - 1);
+    m_keys.push_back((std::uint64_t(layer) << LAYER_SHIFT)
+                     | (std::uint64_t(shader) << SHADER_SHIFT)
+                     | (geometry << GEOMETRY_SHIFT));
+    return true;
+}
+
+void RenderQueue::computeLevels()
+{
+    std::size_t n = m_items.size();
+    m_levels.assign(n, 0);
+    if (n == 0) {
+        return;
+    }
+
+    // Bucket the boxes into a grid over the whole frame. Each cell remembers the highest
+    // level of any box that touched it, which is an upper bound for the levels of the boxes
+    // actually overlapping a new one: levels may come out higher than needed, never lower.
+    glm::vec2 lo(INFINITY), hi(-INFINITY);
+    for (const glm::vec4& b : m_bounds) {
+        lo = glm::min(lo, glm::vec2(b.x, b.y));
+        hi = glm::max(hi, glm::vec2(b.z, b.w));
+    }
+    int gridSize = std::max(1, std::min(MAX_GRID_SIZE, int(std::sqrt(double(n)))));
+    glm::vec2 extent = glm::max(hi - lo, glm::vec2(1e-6f));
+    glm::vec2 toCell = glm::vec2(gridSize) / extent;
+    auto cellOf = [&](float v, float origin, float scale) {
+        return std::min(gridSize - 1, std::max(0, int((v - origin) * scale)));
+    };
+
+    // Layers are ordered by the key anyway, so each one gets its own grid and levels
+    for (auto& grid : m_layerGrids) {
+        grid.second.assign(gridSize * gridSize, 0);
+    }
+    std::uint32_t maxLevel = (1u << LEVEL_BITS) - 1;
+    std::vector<std::uint32_t>* cells = nullptr;
+    int cellsLayer = -1;
+
+    for (std::size_t i = 0; i < n; i++) {
+        int layer = int(m_keys[i] >> LAYER_SHIFT);
+        if (layer != cellsLayer) {
+            auto it = std::find_if(m_layerGrids.begin(), m_layerGrids.end(),
+                                   [layer](const auto& grid) { return grid.first == layer; });
+            if (it == m_layerGrids.end()) {
+                m_layerGrids.emplace_back(std::uint8_t(layer), std::vector<std::uint32_t>(gridSize * gridSize, 0));
+                it = std::prev(m_layerGrids.end());
+            }
+            cells = &it->second;
+            cellsLayer = layer;
+        }
+
+        const glm::vec4& b = m_bounds[i];
+        int x0 = cellOf(b.x, lo.x, toCell.x), x1 = cellOf(b.z, lo.x, toCell.x);
+        int y0 = cellOf(b.y, lo.y, toCell.y), y1 = cellOf(b.w, lo.y, toCell.y);
+        std::uint32_t level = 0;
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                level = std::max(level, (*cells)[y * gridSize + x]);
+            }
+        }
+        m_levels[i] = level;
+        // Whatever touches these cells later must go above this draw
+        std::uint32_t above = std::min(level + 1, maxLevel);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                (*cells)[y * gridSize + x] = above;
+            }
+        }
+    }
+}
+
+void RenderQueue::sort()
+{
+    computeLevels();
+
+    std::size_t n = m_items.size();
+    m_order.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        m_keys[i] |= std::uint64_t(m_levels[i]) << LEVEL_SHIFT;
+        m_order[i] = i;
+    }
+    radixSort(m_keys, m_order);
+}
+
+void RenderQueue::radixSort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& payloads)
+{
+    std::size_t n = keys.size();
+    if (n < 2) {
+        return;
+    }
+    std::vector<std::uint64_t> scratchKeys(n);
+    std::vector<std::uint32_t> scratchPayloads(n);
+
+    // Digits that are the same in every key would only copy the data around
+    std::uint64_t differing = 0;
+    for (std::uint64_t k : keys) {
+        differing |= k ^ keys[0];
+    }
+
+    for (int shift = 0; shift < 64; shift += 8) {
+        if (((differing >> shift) & 0xff) == 0) {
+            continue;
+        }
+        std::size_t counts[257] = {};
+        for (std::uint64_t k : keys) {
+            counts[((k >> shift) & 0xff) + 1]++;
+        }
+        for (int d = 0; d < 256; d++) {
+            counts[d + 1] += counts[d];
+        }
+        // Going through the keys in order keeps the sort stable, which each later digit relies on
+        for (std::size_t i = 0; i < n; i++) {
+            std::size_t dst = counts[(keys[i] >> shift) & 0xff]++;
+            scratchKeys[dst] = keys[i];
+            scratchPayloads[dst] = payloads[i];
+        }
+        keys.swap(scratchKeys);
+        payloads.swap(scratchPayloads);
+    }
+}
+
+std::size_t RenderQueue::size() const
+{
+    return m_order.size();
+}
+
+const RenderQueue::Item& RenderQueue::operator[](std::size_t i) const
+{
+    return m_items[m_order[i]];
+}
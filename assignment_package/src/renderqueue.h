@@ -0,0 +1,74 @@
+#pragma once
+
+#include <la.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "drawable.h"
+
+// Collects the draws of a frame and reorders them so that draws of the same
+// shader and geometry end up next to each other, without changing what the
+// frame looks like.
+// Draws are painted back to front in the order they were pushed, so a draw may
+// only be moved past draws it doesn't overlap. sort() gives every draw an
+// overlap level: one more than the highest level among earlier draws whose
+// screen-space boxes it touches. Draws on the same level never overlap, so
+// they can be put in any order; sorting by (layer, level, shader, geometry)
+// keeps every overlapping pair in push order and groups everything else.
+class RenderQueue
+{
+public:
+    struct Item {
+        Drawable* drawable;
+        glm::mat3 model;
+        glm::vec3 color;
+    };
+
+    RenderQueue();
+
+    // Forgets the previous frame's draws
+    void clear();
+    // Drops every draw pushed from now on whose box lies entirely outside [min, max].
+    // Nothing is culled until this is called.
+    void setCullBounds(const glm::vec2& min, const glm::vec2& max);
+    // True if box, (min x, min y, max x, max y) in world space, lies entirely outside the
+    // cull bounds. An empty box (min > max) always does.
+    bool isCulled(const glm::vec4& box) const;
+    // The world-space box around the corners of [boundsMin, boundsMax] transformed by model
+    static glm::vec4 worldBox(const glm::mat3& model, const glm::vec2& boundsMin, const glm::vec2& boundsMax);
+    // Records a draw of d with the given transformation and color. box is d's
+    // world-space box, from worldBox(). Lower layers are always drawn first; within a
+    // layer, a draw covers the earlier draws it overlaps. shader identifies the program
+    // the draw needs, so that draws with the same one can be grouped.
+    // Returns false if the draw was culled.
+    bool push(Drawable& d, const glm::mat3& model, const glm::vec3& color,
+              const glm::vec4& box, std::uint8_t layer = 0, std::uint8_t shader = 0);
+    // Computes every draw's sort key and radix-sorts them
+    void sort();
+
+    // The draws in the order sort() chose
+    std::size_t size() const;
+    const Item& operator[](std::size_t i) const;
+
+    // Sorts keys (with the payloads riding along) in ascending order using an LSD radix
+    // sort over 8-bit digits, skipping digits on which every key agrees
+    static void radixSort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& payloads);
+
+private:
+    // Sets each draw's overlap level
+    void computeLevels();
+
+    std::vector<Item> m_items;
+    std::vector<glm::vec4> m_bounds;          // World-space box of each draw: (min x, min y, max x, max y)
+    std::vector<std::uint32_t> m_levels;
+    std::vector<std::uint64_t> m_keys;        // Key of each draw, partially filled in by push()
+    std::vector<std::uint32_t> m_order;       // Indices into m_items in draw order, valid after sort()
+    glm::vec4 m_cullBounds;                   // Draws outside this box are dropped: (min x, min y, max x, max y)
+
+    // Scratch space of computeLevels: a grid of levels for each layer in use
+    std::vector<std::pair<std::uint8_t, std::vector<std::uint32_t>>> m_layerGrids;
+
+    const Drawable* mp_lastDrawable;          // Speeds up looking up geometry ids for runs of the same shape
+    std::uint32_t m_lastGeometryId;
+    std::unordered_map<const Drawable*, std::uint32_t> m_geometries; // Geometry id of each Drawable seen this frame
+};
@@ -0,0 +1,171 @@
+#include "geometryregistry.h"
+#include <cstring>
+
+// Side counts of the circle's levels of detail
+const static int CIRCLE_LOD_SIDES[] = {16, 32, 64, 128, 256};
+
+// FNV-1a over the raw bytes of the positions
+static std::uint64_t hashPositions(const std::vector<glm::vec3>& positions)
+{
+    std::uint64_t h = 14695981039346656037ull;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(positions.data());
+    std::size_t n = positions.size() * sizeof(glm::vec3);
+    for (std::size_t i = 0; i < n; i++) {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+GeometryRegistry::GeometryRegistry(OpenGLContext* context)
+    : mp_context(context), m_buffer(context), m_entries(),
+      m_circleLods(), m_circlePins(), m_lodChains(), m_count(0), m_hasPending(false)
+{}
+
+GeometryRegistry::~GeometryRegistry()
+{
+    // The pins point into m_entries, so they must go first
+    m_circlePins.clear();
+}
+
+Polygon2D* GeometryRegistry::polygon(const std::vector<glm::vec3>& positions)
+{
+    std::uint64_t hash = hashPositions(positions);
+    if (Polygon2D* existing = find(hash, positions)) {
+        return existing;
+    }
+    return add(hash, mkU<Polygon2D>(mp_context, positions));
+}
+
+Polygon2D* GeometryRegistry::regularPolygon(int numSides)
+{
+    Polygon2D* result = exactRegularPolygon(numSides);
+    if (numSides > CIRCLE_MIN_SIDES) {
+        if (m_circleLods.empty()) {
+            for (int sides : CIRCLE_LOD_SIDES) {
+                Polygon2D* level = exactRegularPolygon(sides);
+                m_circleLods.push_back(level);
+                m_circlePins.push_back(level);
+            }
+        }
+        // Rebuilt on every call: the polygon may be a new one, if an earlier polygon
+        // with this side count was collected
+        std::vector<Polygon2D*>& chain = m_lodChains[numSides];
+        chain.clear();
+        for (Polygon2D* level : m_circleLods) {
+            if (int(level->vertexCount()) < numSides) {
+                chain.push_back(level);
+            }
+        }
+        chain.push_back(result);
+        result->setLodChain(&chain);
+    }
+    return result;
+}
+
+Polygon2D* GeometryRegistry::exactRegularPolygon(int numSides)
+{
+    // Cheap to build, so build it first to find its positions
+    uPtr<Polygon2D> geometry = mkU<Polygon2D>(mp_context, numSides);
+    std::uint64_t hash = hashPositions(geometry->positions());
+    if (Polygon2D* existing = find(hash, geometry->positions())) {
+        return existing;
+    }
+    return add(hash, std::move(geometry));
+}
+
+Polygon2D* GeometryRegistry::find(std::uint64_t hash, const std::vector<glm::vec3>& positions)
+{
+    auto it = m_entries.find(hash);
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+    for (Entry& e : it->second) {
+        if (e.positions == positions) {
+            return e.geometry.get();
+        }
+    }
+    return nullptr;
+}
+
+Polygon2D* GeometryRegistry::add(std::uint64_t hash, uPtr<Polygon2D> geometry)
+{
+    Polygon2D* result = geometry.get();
+    std::vector<glm::vec3> positions = geometry->positions();
+    m_entries[hash].push_back({std::move(geometry), std::move(positions), false});
+    m_count++;
+    m_hasPending = true;
+    return result;
+}
+
+void GeometryRegistry::createPending()
+{
+    if (!m_hasPending) {
+        return;
+    }
+    for (auto& kv : m_entries) {
+        for (Entry& e : kv.second) {
+            if (!e.created) {
+                e.geometry->create(m_buffer);
+                e.created = true;
+            }
+        }
+    }
+    m_hasPending = false;
+}
+
+void GeometryRegistry::collectUnused()
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        std::vector<Entry>& bucket = it->second;
+        for (std::size_t i = 0; i < bucket.size();) {
+            if (bucket[i].geometry->refCount() == 0) {
+                // ~Drawable hands its range back to m_buffer
+                bucket.erase(bucket.begin() + i);
+                m_count--;
+            } else {
+                i++;
+            }
+        }
+        it = bucket.empty() ? m_entries.erase(it) : std::next(it);
+    }
+}
+
+std::size_t GeometryRegistry::size() const
+{
+    return m_count;
+}
+
+GeometryBuffer& GeometryRegistry::buffer()
+{
+    return m_buffer;
+}
+
+const GeometryBuffer& GeometryRegistry::buffer() const
+{
+    return m_buffer;
+}
+
+std::vector<const Polygon2D*> GeometryRegistry::polygons() const
+{
+    std::vector<const Polygon2D*> result;
+    result.reserve(m_count);
+    for (const auto& kv : m_entries) {
+        for (const Entry& e : kv.second) {
+            result.push_back(e.geometry.get());
+        }
+    }
+    return result;
+}
+
+std::size_t GeometryRegistry::keyBytes() const
+{
+    std::size_t bytes = 0;
+    for (const auto& kv : m_entries) {
+        bytes += kv.second.capacity() * sizeof(Entry);
+        for (const Entry& e : kv.second) {
+            bytes += e.positions.capacity() * sizeof(glm::vec3);
+        }
+    }
+    return bytes;
+}
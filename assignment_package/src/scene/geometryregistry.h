@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <smartpointerhelp.h>
+#include "polygon.h"
+#include "geometrybuffer.h"
+
+// Owns every Polygon2D that Nodes can point to. Asking for a shape that is
+// already registered (same vertex positions) returns the existing Polygon2D,
+// so all Nodes drawing that shape share one range of GPU memory. Every
+// shape is stored in the same GeometryBuffer, so drawing a mix of them
+// needs no buffer switches.
+// Polygons are destroyed once no GeometryRef points to them anymore.
+class GeometryRegistry
+{
+public:
+    GeometryRegistry(OpenGLContext* context);
+    ~GeometryRegistry();
+
+    // Returns the polygon with exactly these vertex positions, registering it if needed.
+    // The outline is only triangulated the first time it is registered.
+    Polygon2D* polygon(const std::vector<glm::vec3>& positions);
+    // Returns a regular polygon with numSides sides, as built by Polygon2D(context, numSides).
+    // With more than CIRCLE_MIN_SIDES sides, lodFor() may draw it with fewer when it is small
+    // on screen: with one of the circle's levels of detail that has fewer sides than it.
+    // Up close it is drawn with exactly numSides sides.
+    Polygon2D* regularPolygon(int numSides);
+
+    // Regular polygons with more sides than this get levels of detail
+    const static int CIRCLE_MIN_SIDES = 16;
+
+    // Creates the GPU buffers of polygons registered since the last call.
+    // Must be called with the OpenGL context current, before drawing.
+    void createPending();
+    // Destroys the polygons that nothing refers to anymore.
+    // Must be called with the OpenGL context current.
+    void collectUnused();
+
+    // Number of registered polygons, i.e. of ranges in buffer()
+    std::size_t size() const;
+
+    // The buffer every registered polygon's vertices and indices are stored in
+    GeometryBuffer& buffer();
+    const GeometryBuffer& buffer() const;
+
+    // Every registered polygon, in no particular order
+    std::vector<const Polygon2D*> polygons() const;
+    // Bytes of the copies of each shape's positions kept to look shapes up
+    std::size_t keyBytes() const;
+
+private:
+    // regularPolygon() without the level of detail
+    Polygon2D* exactRegularPolygon(int numSides);
+    // Returns the registered polygon with these positions, or nullptr
+    Polygon2D* find(std::uint64_t hash, const std::vector<glm::vec3>& positions);
+    // Registers geometry, which must not be registered yet, under hash
+    Polygon2D* add(std::uint64_t hash, uPtr<Polygon2D> geometry);
+
+    struct Entry {
+        uPtr<Polygon2D> geometry;
+        std::vector<glm::vec3> positions; // Kept to tell apart shapes whose hashes collide
+        bool created;                     // Whether geometry->create() has been called
+    };
+
+    OpenGLContext* mp_context;
+    // Declared before m_entries so it outlives the polygons returning their ranges to it
+    GeometryBuffer m_buffer;
+    // Registered polygons, grouped by a hash of their vertex positions
+    std::unordered_map<std::uint64_t, std::vector<Entry>> m_entries;
+    // The circle's levels of detail, from CIRCLE_MIN_SIDES sides up. Built on first use
+    // and kept for good, since any circle may need any of them.
+    std::vector<Polygon2D*> m_circleLods;
+    std::vector<GeometryRef> m_circlePins;
+    // The LOD chain of the regular polygon with each side count: the levels with fewer
+    // sides, then the polygon itself. Elements of an unordered_map never move, so
+    // polygons can point to the chains.
+    std::unordered_map<int, std::vector<Polygon2D*>> m_lodChains;
+    std::size_t m_count;
+    bool m_hasPending; // True if some entry hasn't been created yet
+};
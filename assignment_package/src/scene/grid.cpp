@@ -7,35 +7,42 @@ const static int NUM_IDX = 36;
 Grid::Grid(OpenGLContext *context) : Drawable(context)
 {}
 
-void Grid::create()
+void Grid::vertices(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& colors)
 {
-    GLuint idx[NUM_IDX];
-    glm::vec3 vertPos[NUM_IDX];
-    glm::vec3 vertCol[NUM_IDX];
+    positions.resize(NUM_IDX);
+    colors.resize(NUM_IDX);
 
-    for (int i = 0; i < NUM_IDX; i++)
-    {
-        idx[i] = i;
-    }
-
-    // -4 to 4
+    // -4 to 4. z is 1 so that the view's translation (panning) applies, as it does to polygons
     for (int row = 0; row < 9; row++)
     {
-        vertPos[row * 2] = glm::vec3(row - 4.f, 5.f, 0.f);
-        vertPos[row * 2 + 1] = glm::vec3(row - 4.f, -5.f, 0.f);
+        positions[row * 2] = glm::vec3(row - 4.f, 5.f, 1.f);
+        positions[row * 2 + 1] = glm::vec3(row - 4.f, -5.f, 1.f);
     }
     for (int col = 0; col < 9; col++)
     {
-        vertPos[col * 2 + 18] = glm::vec3(5.f, col - 4.f, 0.f);
-        vertPos[col * 2 + 19] = glm::vec3(-5.f, col - 4.f, 0.f);
+        positions[col * 2 + 18] = glm::vec3(5.f, col - 4.f, 1.f);
+        positions[col * 2 + 19] = glm::vec3(-5.f, col - 4.f, 1.f);
     }
 
     for (int i = 0; i < NUM_IDX; i++)
     {
-        vertCol[i] = glm::vec3(0,0,0);
+        colors[i] = glm::vec3(0,0,0);
+    }
+    colors[8] = colors[9] = glm::vec3(1,1,1);
+    colors[26] = colors[27] = glm::vec3(1,1,1);
+}
+
+void Grid::create()
+{
+    GLuint idx[NUM_IDX];
+    std::vector<glm::vec3> vertPos;
+    std::vector<glm::vec3> vertCol;
+
+    for (int i = 0; i < NUM_IDX; i++)
+    {
+        idx[i] = i;
     }
-    vertCol[8] = vertCol[9] = glm::vec3(1,1,1);
-    vertCol[26] = vertCol[27] = glm::vec3(1,1,1);
+    vertices(vertPos, vertCol);
 
     m_count = NUM_IDX;
 
@@ -52,11 +59,11 @@ void Grid::create()
     // array buffers rather than element array buffers, as they store vertex attributes like position.
     generatePos();
     mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPos);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, NUM_IDX * sizeof(glm::vec3), vertPos, GL_STATIC_DRAW);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, NUM_IDX * sizeof(glm::vec3), vertPos.data(), GL_STATIC_DRAW);
 
     generateCol();
     mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufCol);
-    mp_context->glBufferData(GL_ARRAY_BUFFER, NUM_IDX * sizeof(glm::vec3), vertCol, GL_STATIC_DRAW);
+    mp_context->glBufferData(GL_ARRAY_BUFFER, NUM_IDX * sizeof(glm::vec3), vertCol.data(), GL_STATIC_DRAW);
 }
 
 GLenum Grid::drawMode()
@@ -12,5 +12,9 @@ public:
     Grid(OpenGLContext* context);
     void create() override;
 
+    // The grid's line segments (pairs of positions) and the color of each vertex,
+    // for renderers that don't go through OpenGL
+    static void vertices(std::vector<glm::vec3>& positions, std::vector<glm::vec3>& colors);
+
     GLenum drawMode() override;
 };
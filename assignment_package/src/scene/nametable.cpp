@@ -0,0 +1,71 @@
+#include "nametable.h"
+#include <QHash>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+
+// Per name overhead of the lookup table: one hash node holding the key and id
+const static std::size_t HASH_ENTRY_BYTES = sizeof(void*) + sizeof(QString) + sizeof(NameTable::Id) + sizeof(std::size_t);
+// The header in front of every QString's characters
+const static std::size_t STRING_HEADER_BYTES = 16;
+
+namespace {
+struct Table {
+    std::shared_mutex mutex;
+    std::deque<QString> names; // Indexed by id. A deque never moves its elements.
+    QHash<QString, NameTable::Id> ids;
+    std::size_t characterBytes = 0;
+};
+
+Table& table()
+{
+    static Table t;
+    return t;
+}
+}
+
+NameTable::Id NameTable::intern(const QString& name)
+{
+    Table& t = table();
+    {
+        // Most names are already there, and many readers can look at once
+        std::shared_lock<std::shared_mutex> lock(t.mutex);
+        auto it = t.ids.constFind(name);
+        if (it != t.ids.constEnd()) {
+            return it.value();
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(t.mutex);
+    // Another thread may have added it since the shared lock was released
+    auto it = t.ids.constFind(name);
+    if (it != t.ids.constEnd()) {
+        return it.value();
+    }
+    Id id = Id(t.names.size());
+    t.names.push_back(name);
+    t.ids.insert(name, id);
+    t.characterBytes += STRING_HEADER_BYTES + (name.capacity() + 1) * sizeof(QChar);
+    return id;
+}
+
+const QString& NameTable::name(Id id)
+{
+    Table& t = table();
+    std::shared_lock<std::shared_mutex> lock(t.mutex);
+    return t.names[id];
+}
+
+std::size_t NameTable::size()
+{
+    Table& t = table();
+    std::shared_lock<std::shared_mutex> lock(t.mutex);
+    return t.names.size();
+}
+
+std::size_t NameTable::memoryBytes()
+{
+    Table& t = table();
+    std::shared_lock<std::shared_mutex> lock(t.mutex);
+    // The hash's key shares its characters with the entry in names
+    return t.characterBytes + t.names.size() * (sizeof(QString) + HASH_ENTRY_BYTES);
+}
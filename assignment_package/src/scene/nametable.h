@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QString>
+#include <cstdint>
+
+// Interned node names. Each distinct name is stored once, and nodes keep its
+// 32-bit id instead of a string of their own. Scene graphs repeat a handful of
+// names ("newTranslateNode", the names in a duplicated subtree) many times over.
+// Names are never removed. Safe to use from several threads.
+class NameTable
+{
+public:
+    typedef std::uint32_t Id;
+
+    // Returns the id of name, adding it to the table if it isn't there yet
+    static Id intern(const QString& name);
+    // The name with the given id. The reference stays valid for the life of the program.
+    static const QString& name(Id id);
+
+    // Number of distinct names, and the bytes the table takes for them
+    static std::size_t size();
+    static std::size_t memoryBytes();
+};
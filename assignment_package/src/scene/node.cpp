@@ -1,37 +1,64 @@
 #include "node.h"
+#include <algorithm>
+#include <cmath>
+
+// Guards the compact layout: a member added here costs its size once per node,
+// on scenes of millions of nodes
+static_assert(sizeof(void*) != 8 || sizeof(TranslateNode) <= 120,
+              "transformation nodes grew; keep rarely used data out of Node");
 
 //constructor implementation:
 
-Node::Node(const QString& nodeName) : polygon(nullptr), color(0.0f, 0.0f, 0.0f), name(nodeName) {
-    //TreeWidget modification
-    this->setText(0, name);
+Node::Node(const QString& nodeName) : Node(nodeName, NodeType::Plain) {}
+
+#ifdef SCENEGRAPH_PACKED_COLORS
+static std::uint32_t packColor(const glm::vec3& c) {
+    glm::uvec3 bytes(glm::round(glm::clamp(c, 0.f, 1.f) * 255.f));
+    return bytes.r | (bytes.g << 8) | (bytes.b << 16);
+}
+
+static glm::vec3 unpackColor(std::uint32_t c) {
+    return glm::vec3(c & 0xff, (c >> 8) & 0xff, (c >> 16) & 0xff) / 255.f;
+}
+#else
+static const glm::vec3& packColor(const glm::vec3& c) {
+    return c;
 }
 
-// copy constructr
+static const glm::vec3& unpackColor(const glm::vec3& c) {
+    return c;
+}
+#endif
+
+Node::Node(const QString& nodeName, NodeType nodeType) : Node(NameTable::intern(nodeName), nodeType) {}
+
+Node::Node(NameTable::Id nameId, NodeType nodeType)
+    : parent(nullptr), polygon(nullptr), worldTransform(1.0f),
+      subtreeBounds(INFINITY, INFINITY, -INFINITY, -INFINITY), color(packColor(glm::vec3(0.0f))),
+      name(nameId), transformDirty(true), boundsDirty(true), type(nodeType) {
+}
+
+// copy constructor
 // needs to make a deep copy
-// for each chld determine what node it is
-// dynamicast<Node*>
-// if dynamic cast fails, the pointer will point to 0
-// covered in lecture!!!
-Node::Node(const Node& other)
+// each child copies itself through clone(), which switches on the
+// node's type tag instead of a dynamic_cast chain.
+// The copy itself is only what Node holds, so it must not keep a derived
+// type's tag: localTransformation() would read parameters it doesn't have.
+Node::Node(const Node& other) : Node(other, NodeType::Plain) {}
+
+Node::Node(const Node& other, NodeType nodeType)
     :
+    parent(nullptr),
     polygon(other.polygon),
+    worldTransform(1.0f),
+    subtreeBounds(INFINITY, INFINITY, -INFINITY, -INFINITY),
     color(other.color),
-    name(other.name){
-
-    for (const auto& child : other.children) {
-        // Using dynamic_cast to ascertain the type of each child
-        if (auto translateNode = dynamic_cast<TranslateNode*>(child.get())) {
-            children.push_back(std::make_unique<TranslateNode>(*translateNode));
-        } else if (auto rotateNode = dynamic_cast<RotateNode*>(child.get())) {
-            children.push_back(std::make_unique<RotateNode>(*rotateNode));
-        } else if (auto scaleNode = dynamic_cast<ScaleNode*>(child.get())) {
-            children.push_back(std::make_unique<ScaleNode>(*scaleNode));
-        } else {
-            // If it's a base Node type or some other unknown type:
-            children.push_back(std::make_unique<Node>(*child));
-        }
-    }
+    name(other.name),
+    transformDirty(true),
+    boundsDirty(true),
+    type(nodeType){
+
+    cloneChildrenFrom(other);
 }
 
 Node& Node::operator=(const Node& other) {
@@ -39,28 +66,69 @@ Node& Node::operator=(const Node& other) {
         color = other.color;
         name = other.name;
         polygon = other.polygon;
+        transformDirty = true;
+        markBoundsDirty();
 
         children.clear();
+        cloneChildrenFrom(other);
+    }
+    return *this;
+}
 
-        //    for (uPtr<Node> &n : children){
-        //        TranslateNode *tn = dynamic_cast<Node*>(n);
-        //    }
-
-        for (const auto& child : other.children) {
-            if (auto translateNode = dynamic_cast<TranslateNode*>(child.get())) {
-                children.push_back(std::make_unique<TranslateNode>(*translateNode));
-            } else if (auto rotateNode = dynamic_cast<RotateNode*>(child.get())) {
-                children.push_back(std::make_unique<RotateNode>(*rotateNode));
-            } else if (auto scaleNode = dynamic_cast<ScaleNode*>(child.get())) {
-                children.push_back(std::make_unique<ScaleNode>(*scaleNode));
-            } else {
-                children.push_back(std::make_unique<Node>(*child));
-            }
+void Node::cloneChildrenFrom(const Node& other) {
+    // Walk the source subtree with an explicit stack instead of recursing,
+    // so very deep branches can't overflow the call stack.
+    // Each pair is (node to copy children from, node to copy them into).
+    std::vector<std::pair<const Node*, Node*>> stack;
+    stack.emplace_back(&other, this);
+
+    while (!stack.empty()) {
+        const Node* src = stack.back().first;
+        Node* dst = stack.back().second;
+        stack.pop_back();
+
+        // size the children vector once instead of growing it child by child
+        dst->children.reserve(dst->children.size() + src->children.size());
+
+        for (const uPtr<Node>& child : src->children) {
+            uPtr<Node> copy = child->clone();
+            copy->parent = dst;
+            stack.emplace_back(child.get(), copy.get());
+            dst->children.push_back(std::move(copy));
         }
-        // update name in TreeWidget
-        this->setText(0, name);
     }
-    return *this;
+}
+
+uPtr<Node> Node::clone() const {
+    // The copy shares the interned name, so the table isn't locked and searched per node
+    uPtr<Node> copy;
+    switch (type) {
+    case NodeType::Translate: {
+        const TranslateNode* tn = static_cast<const TranslateNode*>(this);
+        copy = mkU<TranslateNode>(name, tn->getTX(), tn->getTY());
+        break;
+    }
+    case NodeType::Rotate:
+        copy = mkU<RotateNode>(name, static_cast<const RotateNode*>(this)->getRotate());
+        break;
+    case NodeType::Scale: {
+        const ScaleNode* sn = static_cast<const ScaleNode*>(this);
+        copy = mkU<ScaleNode>(name, sn->getSX(), sn->getSY());
+        break;
+    }
+    case NodeType::Plain:
+        copy.reset(new Node(name, NodeType::Plain));
+        break;
+    }
+    copy->color = color;
+    copy->polygon = polygon;
+    return copy;
+}
+
+uPtr<Node> Node::cloneSubtree() const {
+    uPtr<Node> copy = clone();
+    copy->cloneChildrenFrom(*this);
+    return copy;
 }
 
 Node::~Node() = default;
@@ -69,32 +137,152 @@ Node::~Node() = default;
 glm::mat3 Node::computeTransformationMatrix() {
     return glm::mat3(1.0f); // identity matrix
 }
-Node& Node::addChild(uPtr<Node> n) {
+Node& Node::addChild(uPtr<Node> n, SceneChangeLog* log) {
     Node& ref = *n;
+    // its world transformation was relative to wherever it was before
+    ref.markTransformDirty();
+    ref.parent = this;
     this->children.push_back(std::move(n));
-    //update Tree Widget
-    this->QTreeWidgetItem::addChild(&ref);
+    markBoundsDirty();
+    if (log) {
+        log->nodeAdded(&ref, this);
+    }
     return ref;
 }
 
+void Node::addChildren(std::vector<uPtr<Node>> nodes, SceneChangeLog* log) {
+    children.reserve(children.size() + nodes.size());
+    for (uPtr<Node>& n : nodes) {
+        n->markTransformDirty();
+        n->parent = this;
+        if (log) {
+            log->nodeAdded(n.get(), this);
+        }
+        children.push_back(std::move(n));
+    }
+    markBoundsDirty();
+}
+
+void Node::reserveChildren(std::size_t count) {
+    children.reserve(children.size() + count);
+}
+
+glm::mat3 Node::localTransformation() {
+    // Qualified calls are resolved at compile time, so this skips the
+    // virtual dispatch that computeTransformationMatrix() would need
+    switch (type) {
+    case NodeType::Translate:
+        return static_cast<TranslateNode*>(this)->TranslateNode::computeTransformationMatrix();
+    case NodeType::Rotate:
+        return static_cast<RotateNode*>(this)->RotateNode::computeTransformationMatrix();
+    case NodeType::Scale:
+        return static_cast<ScaleNode*>(this)->ScaleNode::computeTransformationMatrix();
+    case NodeType::Plain:
+        break;
+    }
+    return Node::computeTransformationMatrix();
+}
+
+void Node::markTransformDirty() {
+    transformDirty = true;
+    markBoundsDirty();
+}
+
+void Node::markBoundsDirty() {
+    // An ancestor of a dirty node is dirty already, so the walk stops early
+    // when a batch of edits lands in the same subtree
+    for (Node* n = this; n && !n->boundsDirty; n = n->parent) {
+        n->boundsDirty = true;
+    }
+}
+
+const glm::vec4& Node::getSubtreeBounds() const {
+    return subtreeBounds;
+}
+
+bool Node::subtreeBoundsDirty() const {
+    return boundsDirty;
+}
+
+void Node::setSubtreeBounds(const glm::vec4& bounds) {
+    subtreeBounds = bounds;
+    boundsDirty = false;
+}
+
+bool Node::updateWorldTransform(const glm::mat3& parentWorld, bool parentChanged) {
+    if (!transformDirty && !parentChanged) {
+        return false;
+    }
+    worldTransform = parentWorld * localTransformation();
+    transformDirty = false;
+    return true;
+}
+
+const glm::mat3& Node::getWorldTransform() const {
+    return worldTransform;
+}
+
+uPtr<Node> Node::removeChild(Node* n, SceneChangeLog* log) {
+    for (auto it = children.begin(); it != children.end(); ++it) {
+        if (it->get() == n) {
+            uPtr<Node> removed = std::move(*it);
+            children.erase(it);
+            removed->parent = nullptr;
+            markBoundsDirty();
+            if (log) {
+                log->nodeRemoved(n, this);
+            }
+            return removed;
+        }
+    }
+    return nullptr;
+}
+
 void Node::setColor(const glm::vec3& color){
-    this->color = color;
+    this->color = packColor(color);
 }
 
 void Node::setGeometry(Polygon2D* geometry) {
     polygon = geometry;
+    markBoundsDirty();
+}
+
+Node::ChildList& Node::getChildren() {
+    return children;
 }
 
-std::vector<uPtr<Node>>& Node::getChildren() {
+const Node::ChildList& Node::getChildren() const {
     return children;
 }
 
+Node* Node::getParent() const {
+    return parent;
+}
+
+const QString& Node::getName() const {
+    return NameTable::name(name);
+}
+
+void Node::setName(const QString& nodeName, SceneChangeLog* log) {
+    NameTable::Id id = NameTable::intern(nodeName);
+    if (id != name) {
+        name = id;
+        if (log) {
+            log->nodeRenamed(this);
+        }
+    }
+}
+
 Polygon2D* Node::getPolygon() const {
-        return polygon;
+        return polygon.get();
 }
 
 glm::vec3 Node::getColor() const {
-        return color;
+        return unpackColor(color);
+}
+
+NodeType Node::getType() const {
+    return type;
 }
 
 //A purely virtual function that computes and returns a 3x3 homogeneous matrix representing the transformation in the node.
@@ -110,9 +298,18 @@ glm::mat3 TranslateNode::computeTransformationMatrix() {
 
 void TranslateNode::setTX(float x){
     xTranslation = x;
+    markTransformDirty();
 }
 void TranslateNode::setTY(float y){
     yTranslation = y;
+    markTransformDirty();
+}
+
+float TranslateNode::getTX() const {
+    return xTranslation;
+}
+float TranslateNode::getTY() const {
+    return yTranslation;
 }
 
 glm::mat3 RotateNode::computeTransformationMatrix() {
@@ -127,6 +324,11 @@ glm::mat3 RotateNode::computeTransformationMatrix() {
 
 void RotateNode::setRotate(float rotationValue){
     rotationMagnitude = rotationValue;
+    markTransformDirty();
+}
+
+float RotateNode::getRotate() const {
+    return rotationMagnitude;
 }
 
 
@@ -140,8 +342,17 @@ glm::mat3 ScaleNode::computeTransformationMatrix() {
 
 void ScaleNode::setSX(float x){
     xScale = x;
+    markTransformDirty();
 
 }
 void ScaleNode::setSY(float y){
     yScale = y;
+    markTransformDirty();
+}
+
+float ScaleNode::getSX() const {
+    return xScale;
+}
+float ScaleNode::getSY() const {
+    return yScale;
 }
@@ -1,24 +1,75 @@
 #pragma once
-#include <QTreeWidgetItem>
+#include <QString>
 #include <vector>
 #include <smartpointerhelp.h>
+#include <smallvector.h>
 #include "polygon.h"
+#include "nametable.h"
+#include "scenechangelog.h"
 
 // NODE CLASS
 
-//Node class inherits from QTreeWidgetItem
-class Node : public QTreeWidgetItem {
+//Tag identifying which class a Node really is, so code that needs the
+//derived type can switch on it instead of trying dynamic_casts or calling virtuals
+enum class NodeType : unsigned char { Plain, Translate, Rotate, Scale };
+
+//Scenes can have millions of nodes, so the members are kept small: the name is an id into
+//the shared NameTable, and up to one child is stored without an allocation.
+//On 64-bit builds a transformation node is 120 bytes (112 with packed colors), against
+//about 370 when nodes held a QString name and were QTreeWidgetItems.
+//Nodes aren't widgets: the Tree Widget keeps rows of its own for the nodes it shows
+//and learns about edits through the SceneChangeLog the scene's owner passes to them.
+class Node {
     // TODO
 
+public:
+    // Most nodes have no child or a single one
+    typedef SmallVector<uPtr<Node>, 1> ChildList;
+
 private:
     // A set of unique_ptrs to the node's children.
-    std::vector<uPtr<Node>> children;
-    //A raw, C-style pointer to one instance of Polygon2D
-    Polygon2D* polygon;
-    //The color with which to draw the Polygon2D pointed to by the node,
+    ChildList children;
+    //The node this one is a child of, or nullptr for a root or a detached node
+    Node* parent;
+    //A reference-counted pointer to one instance of Polygon2D
+    GeometryRef polygon;
+    //Cached product of every transformation from the root down to this node
+    glm::mat3 worldTransform;
+    //World-space box around everything drawn in this subtree, (min x, min y, max x, max y),
+    //as of the last traversal that visited all of it. min > max if nothing is drawn.
+    glm::vec4 subtreeBounds;
+    //The color with which to draw the Polygon2D pointed to by the node.
+    //Built with SCENEGRAPH_PACKED_COLORS (qmake CONFIG+=packed_colors), 8 bits per channel in one word.
+#ifdef SCENEGRAPH_PACKED_COLORS
+    std::uint32_t color;
+#else
     glm::vec3 color;
-    //QString to represent a name for the node
-    QString name;
+#endif
+    //The node's name, interned in NameTable
+    NameTable::Id name;
+    //True when this node's own transformation changed since worldTransform was last computed
+    bool transformDirty;
+    //True when something in this subtree changed since subtreeBounds was last set
+    bool boundsDirty;
+    //The class of this node, fixed at construction
+    const NodeType type;
+
+    // Deep-copies other's children into this node in a single iterative pass,
+    // using each child's clone() so derived parameters are preserved
+    void cloneChildrenFrom(const Node& other);
+
+    // Marks subtreeBounds stale here and on every ancestor, stopping at one that already is
+    void markBoundsDirty();
+
+protected:
+    //constructors used by the derived classes to set their type
+    Node(const QString& nodeName, NodeType nodeType);
+    Node(NameTable::Id nameId, NodeType nodeType);
+    //copy constructor used by the derived classes' copy constructors to keep their type
+    Node(const Node& other, NodeType nodeType);
+
+    // Must be called by derived classes whenever a value used by computeTransformationMatrix changes
+    void markTransformDirty();
 
 public:
     //CONSTRUCTORS
@@ -26,7 +77,8 @@ public:
     //constructor
     Node(const QString& nodeName);
 
-    //copy constructor
+    //copy constructor. Copies other's name, color, geometry and children, but the copy is
+    //a plain Node even if other is a derived class: use clone() or cloneSubtree() to keep the type.
     Node(const Node& other);
 
     //virtual destructor
@@ -34,14 +86,55 @@ public:
 
     //METHODS
 
-    // assignment operator
+    // assignment operator. Not reported to any SceneChangeLog: replace the children of
+    // a node that is being shown with removeChild and addChildren instead.
     Node& operator=(const Node& other);
 
+    //returns a copy of this node's own data (name, color, geometry and transformation) without its children.
+    //The copy has the same derived type as this node.
+    uPtr<Node> clone() const;
+
+    //returns a deep copy of the whole subtree rooted at this node
+    uPtr<Node> cloneSubtree() const;
+
     //purely virtual function that computes and returns a 3x3 homogeneous matrix representing the transformation in the node.
     virtual glm::mat3 computeTransformationMatrix();
 
+    //This node's own transformation, the same as computeTransformationMatrix() but found
+    //by switching on type rather than through a virtual call
+    glm::mat3 localTransformation();
+
+    //Recomputes worldTransform from the parent's world transformation, but only if this node
+    //or one of its ancestors changed (parentChanged). Returns true if worldTransform was recomputed,
+    //in which case the children need updating too.
+    bool updateWorldTransform(const glm::mat3& parentWorld, bool parentChanged);
+
+    //Getter for the world transformation computed by the last updateWorldTransform
+    const glm::mat3& getWorldTransform() const;
+
+    //The world-space box around everything drawn in this subtree, stored by the traversal.
+    //Only meaningful while subtreeBoundsDirty() is false.
+    const glm::vec4& getSubtreeBounds() const;
+    //True if the subtree was edited or moved since its bounds were last set
+    bool subtreeBoundsDirty() const;
+    //Stores the bounds the traversal found for this subtree and marks them current
+    void setSubtreeBounds(const glm::vec4& bounds);
+
     //A function that adds a given unique_ptr as a child to this node. You'll have to make use of std::move to make this work. Additionally, to make scene graph construction easier for you, this function should return a Node& that refers directly to the Node that is pointed to by the unique_ptr passed into the function. This will allow you to modify that heap-based Node from within your scene graph construction function without worrying about std::move-ing unique pointers around.
-    Node& addChild(uPtr<Node> n);
+    //The structural edits below are reported to log, if given: the scene's owner passes
+    //its SceneChangeLog when this node is in a scene that is being shown.
+    Node& addChild(uPtr<Node> n, SceneChangeLog* log = nullptr);
+
+    //Adds all of nodes as children at once, in order, reserving room for them first.
+    //Attaching subtrees built elsewhere (see SceneBuilder) this way is one change per subtree.
+    void addChildren(std::vector<uPtr<Node>> nodes, SceneChangeLog* log = nullptr);
+
+    //Reservation hint: makes room for count more children, so adding them allocates once
+    void reserveChildren(std::size_t count);
+
+    //Detaches the given child from this node and hands ownership of it back to the caller.
+    //Returns nullptr if n is not a child of this node.
+    uPtr<Node> removeChild(Node* n, SceneChangeLog* log = nullptr);
 
     //A function that allows the user to modify the color stored in this node
     void setColor(const glm::vec3& color);
@@ -50,7 +143,15 @@ public:
     virtual void setGeometry(Polygon2D* geometry);
 
     //Getter for children
-    std::vector<uPtr<Node>>& getChildren();
+    ChildList& getChildren();
+    const ChildList& getChildren() const;
+
+    //Getter for the parent, nullptr for a root or a detached node
+    Node* getParent() const;
+
+    //Getter and setter for the node's name
+    const QString& getName() const;
+    void setName(const QString& nodeName, SceneChangeLog* log = nullptr);
 
     //Getter for Polygon
     Polygon2D* getPolygon() const;
@@ -58,6 +159,9 @@ public:
     //Getter for Color
     glm::vec3 getColor() const;
 
+    //Getter for the node's type
+    NodeType getType() const;
+
 };
 
 // DERIVED CLASSES that inherit from Node Base Class.
@@ -71,18 +175,26 @@ private:
 
 public:
     //call base class constructor
-    TranslateNode(const QString& nodeName, float x, float y) : Node(nodeName), xTranslation(x), yTranslation(y) {}
+    TranslateNode(const QString& nodeName, float x, float y) : Node(nodeName, NodeType::Translate), xTranslation(x), yTranslation(y) {}
+    //with a name already in NameTable, which skips looking it up
+    TranslateNode(NameTable::Id nameId, float x, float y) : Node(nameId, NodeType::Translate), xTranslation(x), yTranslation(y) {}
+    //deep copy, like Node's
+    TranslateNode(const TranslateNode& other) : Node(other, NodeType::Translate), xTranslation(other.xTranslation), yTranslation(other.yTranslation) {}
 
     //destructor
     ~TranslateNode() override = default;
 
     //method to compute the transformation matrix
-    glm::mat3 computeTransformationMatrix() override;
+    glm::mat3 computeTransformationMatrix() final;
 
     //setters
     void setTX(float x);
     void setTY(float y);
 
+    //getters
+    float getTX() const;
+    float getTY() const;
+
 
 };
 
@@ -93,15 +205,22 @@ private:
 
 public:
     //call base class constructor
-    RotateNode(const QString& nodeName, float rotationValue) : Node(nodeName), rotationMagnitude(rotationValue) {}
+    RotateNode(const QString& nodeName, float rotationValue) : Node(nodeName, NodeType::Rotate), rotationMagnitude(rotationValue) {}
+    //with a name already in NameTable, which skips looking it up
+    RotateNode(NameTable::Id nameId, float rotationValue) : Node(nameId, NodeType::Rotate), rotationMagnitude(rotationValue) {}
+    //deep copy, like Node's
+    RotateNode(const RotateNode& other) : Node(other, NodeType::Rotate), rotationMagnitude(other.rotationMagnitude) {}
     //destructor
     ~RotateNode() override = default;
 
     //method to compute the transformation matrix
-    glm::mat3 computeTransformationMatrix() override;
+    glm::mat3 computeTransformationMatrix() final;
 
     //setter
     void setRotate(float rotationValue);
+
+    //getter
+    float getRotate() const;
 };
 
 //ScaleNode, which stores two floating point numbers: one that represents its scale in the X direction, and one that represents its scale in the Y direction.
@@ -112,17 +231,25 @@ private:
 
 public:
     //call base class constructor
-    ScaleNode(const QString& nodeName, float x, float(y)) : Node(nodeName), xScale(x), yScale(y) {}
+    ScaleNode(const QString& nodeName, float x, float(y)) : Node(nodeName, NodeType::Scale), xScale(x), yScale(y) {}
+    //with a name already in NameTable, which skips looking it up
+    ScaleNode(NameTable::Id nameId, float x, float y) : Node(nameId, NodeType::Scale), xScale(x), yScale(y) {}
+    //deep copy, like Node's
+    ScaleNode(const ScaleNode& other) : Node(other, NodeType::Scale), xScale(other.xScale), yScale(other.yScale) {}
 
     //destructor
     ~ScaleNode() override = default;
 
     //method to compute the transformation matrix
-    glm::mat3 computeTransformationMatrix() override;
+    glm::mat3 computeTransformationMatrix() final;
 
     //setters
     void setSX(float x);
     void setSY(float y);
+
+    //getters
+    float getSX() const;
+    float getSY() const;
 };
 
 
@@ -1,12 +1,18 @@
 #include "polygon.h"
+#include "triangulate.h"
 #include <glm/gtx/matrix_transform_2d.hpp>
 
+// How far, in pixels, the edges of a level of detail may lie inside the true outline
+const static float LOD_TOLERANCE_PIXELS = 0.5f;
+
 Polygon2D::Polygon2D(OpenGLContext* context)
-    : Drawable(context), m_vertPos(), m_vertIdx(), m_numVertices(0)
+    : Drawable(context), m_vertPos(), m_vertIdx(), m_numVertices(0),
+      m_boundsMin(0.f), m_boundsMax(0.f), mp_lodChain(nullptr), m_refCount(0)
 {}
 
 Polygon2D::Polygon2D(OpenGLContext* context, int numSides)
-    : Drawable(context), m_vertPos(), m_vertIdx(), m_numVertices(numSides)
+    : Drawable(context), m_vertPos(), m_vertIdx(), m_numVertices(numSides),
+      m_boundsMin(0.f), m_boundsMax(0.f), mp_lodChain(nullptr), m_refCount(0)
 {
     // Vertex positions
     glm::vec3 p(0.5f, 0.f, 1.f);
@@ -24,18 +30,16 @@ Polygon2D::Polygon2D(OpenGLContext* context, int numSides)
         m_vertIdx.push_back(i+1);
         m_vertIdx.push_back(i+2);
     }
+    computeBounds();
 }
 
 Polygon2D::Polygon2D(OpenGLContext* context, const std::vector<glm::vec3>& positions)
-    : Drawable(context), m_vertPos(positions), m_vertIdx(), m_numVertices(positions.size())
+    : Drawable(context), m_vertPos(positions), m_vertIdx(), m_numVertices(positions.size()),
+      m_boundsMin(0.f), m_boundsMax(0.f), mp_lodChain(nullptr), m_refCount(0)
 {
-    int n = m_numVertices - 2;
-    for (int i = 0; i < n; i++)
-    {
-        m_vertIdx.push_back(0);
-        m_vertIdx.push_back(i+1);
-        m_vertIdx.push_back(i+2);
-    }
+    computeBounds();
+    // Indices for triangulation. A fan would only be correct for convex outlines.
+    m_vertIdx = triangulate(m_vertPos);
 }
 
 void Polygon2D::create()
@@ -58,9 +62,24 @@ void Polygon2D::create()
     mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufPos);
     mp_context->glBufferData(GL_ARRAY_BUFFER, m_numVertices * sizeof(glm::vec3), m_vertPos.data(), GL_STATIC_DRAW);
 
-    // Free up memory now that we no longer need the vertex info to be stored on the CPU
-    m_vertIdx.clear();
-    m_vertPos.clear();
+    // Free up memory now that we no longer need the vertex info to be stored on the CPU.
+    // clear() would keep the capacity allocated.
+    std::vector<GLuint>().swap(m_vertIdx);
+    std::vector<glm::vec3>().swap(m_vertPos);
+}
+
+void Polygon2D::create(GeometryBuffer& buffer)
+{
+    m_count = m_vertIdx.size();
+    m_numVertices = m_vertPos.size();
+
+    m_sharedRange = buffer.allocate(m_vertPos, m_vertIdx);
+    mp_sharedBuffer = &buffer;
+    m_idxBound = true;
+    m_posBound = true;
+
+    std::vector<GLuint>().swap(m_vertIdx);
+    std::vector<glm::vec3>().swap(m_vertPos);
 }
 
 void Polygon2D::setColor(glm::vec3 c)
@@ -74,3 +93,148 @@ void Polygon2D::setColor(glm::vec3 c)
     mp_context->glBindBuffer(GL_ARRAY_BUFFER, m_bufCol);
     mp_context->glBufferData(GL_ARRAY_BUFFER, m_numVertices * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
 }
+
+const std::vector<glm::vec3>& Polygon2D::positions() const
+{
+    return m_vertPos;
+}
+
+const std::vector<GLuint>& Polygon2D::indices() const
+{
+    return m_vertIdx;
+}
+
+void Polygon2D::computeBounds()
+{
+    if (m_vertPos.empty()) {
+        return;
+    }
+    m_boundsMin = m_boundsMax = glm::vec2(m_vertPos[0]);
+    for (const glm::vec3& p : m_vertPos)
+    {
+        m_boundsMin = glm::min(m_boundsMin, glm::vec2(p));
+        m_boundsMax = glm::max(m_boundsMax, glm::vec2(p));
+    }
+}
+
+glm::vec2 Polygon2D::boundsMin() const
+{
+    return m_boundsMin;
+}
+
+glm::vec2 Polygon2D::boundsMax() const
+{
+    return m_boundsMax;
+}
+
+unsigned int Polygon2D::vertexCount() const
+{
+    return m_numVertices;
+}
+
+std::size_t Polygon2D::cpuBytes() const
+{
+    return m_vertPos.capacity() * sizeof(glm::vec3) + m_vertIdx.capacity() * sizeof(GLuint);
+}
+
+void Polygon2D::setLodChain(const std::vector<Polygon2D*>* chain)
+{
+    mp_lodChain = chain;
+    for (const Polygon2D* level : *chain) {
+        m_boundsMin = glm::min(m_boundsMin, level->m_boundsMin);
+        m_boundsMax = glm::max(m_boundsMax, level->m_boundsMax);
+    }
+}
+
+const std::vector<Polygon2D*>* Polygon2D::lodChain() const
+{
+    return mp_lodChain;
+}
+
+Polygon2D* Polygon2D::lodFor(float pixelRadius)
+{
+    if (!mp_lodChain || mp_lodChain->empty()) {
+        return this;
+    }
+    if (pixelRadius <= LOD_TOLERANCE_PIXELS) {
+        return mp_lodChain->front();
+    }
+    // An edge of a regular n-gon of radius r bulges r * (1 - cos(pi / n)) inside the circle
+    float needed = glm::pi<float>() / std::acos(1.f - LOD_TOLERANCE_PIXELS / pixelRadius);
+    for (Polygon2D* level : *mp_lodChain) {
+        if (level->vertexCount() >= needed) {
+            return level;
+        }
+    }
+    return mp_lodChain->back();
+}
+
+void Polygon2D::retain()
+{
+    m_refCount++;
+}
+
+void Polygon2D::release()
+{
+    m_refCount--;
+}
+
+int Polygon2D::refCount() const
+{
+    return m_refCount;
+}
+
+GeometryRef::GeometryRef(Polygon2D* geometry)
+    : mp_geometry(geometry)
+{
+    if (mp_geometry) {
+        mp_geometry->retain();
+    }
+}
+
+GeometryRef::GeometryRef(const GeometryRef& other)
+    : GeometryRef(other.mp_geometry)
+{}
+
+GeometryRef::GeometryRef(GeometryRef&& other) noexcept
+    : mp_geometry(other.mp_geometry)
+{
+    other.mp_geometry = nullptr;
+}
+
+GeometryRef::~GeometryRef()
+{
+    if (mp_geometry) {
+        mp_geometry->release();
+    }
+}
+
+GeometryRef& GeometryRef::operator=(const GeometryRef& other)
+{
+    // retain first in case both point to the same polygon
+    if (other.mp_geometry) {
+        other.mp_geometry->retain();
+    }
+    if (mp_geometry) {
+        mp_geometry->release();
+    }
+    mp_geometry = other.mp_geometry;
+    return *this;
+}
+
+GeometryRef& GeometryRef::operator=(GeometryRef&& other) noexcept
+{
+    if (this != &other) {
+        if (mp_geometry) {
+            mp_geometry->release();
+        }
+        mp_geometry = other.mp_geometry;
+        other.mp_geometry = nullptr;
+    }
+    return *this;
+}
+
+Polygon2D* GeometryRef::get() const
+{
+    return mp_geometry;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "drawable.h"
+#include <atomic>
 
 class Polygon2D : public Drawable
 {
@@ -9,15 +10,49 @@ public:
     // Instantiate a regular polygon with N sides and
     // a bounding box of side length 1 centered at the origin
     Polygon2D(OpenGLContext* context, int numSides);
-    // Instantiate a polygon with its vertex positions defined
-    // in counter-clockwise order. These vertices must form a convex
-    // polygon in order to be drawn correctly.
+    // Instantiate a polygon with its vertex positions defined in
+    // either winding order. The outline may be concave but must not
+    // cross itself in order to be drawn correctly.
     Polygon2D(OpenGLContext* context, const std::vector<glm::vec3>& positions);
     // Initialize data required by OpenGL to render the shape
     void create() override;
+    // Like create(), but stores the vertices and indices in a range of the given
+    // shared buffer instead of buffers of this polygon's own
+    void create(GeometryBuffer& buffer);
     // Set the color of the polygon when it's drawn by OpenGL
     void setColor(glm::vec3 c);
 
+    // The vertex positions this polygon was built from.
+    // Only available until create() uploads them to the GPU.
+    const std::vector<glm::vec3>& positions() const;
+    // The triangles' vertex indices, three per triangle. Also cleared by create().
+    const std::vector<GLuint>& indices() const;
+    // Corners of the axis-aligned box around the polygon's vertices. Kept after create().
+    glm::vec2 boundsMin() const;
+    glm::vec2 boundsMax() const;
+
+    // Number of vertices, also known after create()
+    unsigned int vertexCount() const;
+    // Bytes of the positions and indices held on the CPU, which create() frees
+    std::size_t cpuBytes() const;
+
+    // Level of detail. chain holds versions of this shape with increasing vertex
+    // counts (this polygon may be one of them); it must outlive this polygon.
+    // The bounds grow to hold every level, so they stand for whichever one is drawn.
+    void setLodChain(const std::vector<Polygon2D*>* chain);
+    const std::vector<Polygon2D*>* lodChain() const;
+    // The member of the LOD chain with the fewest vertices that still looks smooth
+    // when the polygon is pixelRadius pixels across from its center, or this
+    // polygon if it has no chain
+    Polygon2D* lodFor(float pixelRadius);
+
+    // Reference counting used by GeometryRef, so that a GeometryRegistry
+    // knows when no Node uses this polygon anymore.
+    // Atomic, so nodes built on several threads can share a polygon.
+    void retain();
+    void release();
+    int refCount() const;
+
 protected:
     // The list of vertex positions that define this polygon's shape
     std::vector<glm::vec3> m_vertPos;
@@ -28,4 +63,31 @@ protected:
     // in order to know how many vertices need to be assigned the
     // Polygon's color.
     unsigned int m_numVertices;
+
+private:
+    // Computes m_boundsMin / m_boundsMax from m_vertPos
+    void computeBounds();
+
+    glm::vec2 m_boundsMin;
+    glm::vec2 m_boundsMax;
+    const std::vector<Polygon2D*>* mp_lodChain; // Versions of this shape at other detail levels, or nullptr
+    std::atomic<int> m_refCount; // How many GeometryRefs point to this polygon
+};
+
+// A pointer to a Polygon2D that keeps the polygon's reference count up to date,
+// so geometry stays alive exactly as long as some Node (or undo history) uses it
+class GeometryRef
+{
+public:
+    GeometryRef(Polygon2D* geometry = nullptr);
+    GeometryRef(const GeometryRef& other);
+    GeometryRef(GeometryRef&& other) noexcept;
+    ~GeometryRef();
+    GeometryRef& operator=(const GeometryRef& other);
+    GeometryRef& operator=(GeometryRef&& other) noexcept;
+
+    Polygon2D* get() const;
+
+private:
+    Polygon2D* mp_geometry;
 };
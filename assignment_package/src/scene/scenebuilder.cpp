@@ -0,0 +1,22 @@
+#include "scenebuilder.h"
+#include <algorithm>
+#include <parallelfor.h>
+
+SceneBuilder::SceneBuilder(unsigned int threadCount)
+    : m_threadCount(resolveThreadCount(threadCount))
+{}
+
+std::vector<uPtr<Node>> SceneBuilder::build(int count, const SubtreeFunction& build) const
+{
+    std::vector<uPtr<Node>> subtrees(std::max(count, 0));
+    // Each slot of subtrees is written by exactly one thread
+    parallelFor(count, m_threadCount, [&subtrees, &build, count](int i) { subtrees[i] = build(i, count); });
+
+    subtrees.erase(std::remove(subtrees.begin(), subtrees.end(), nullptr), subtrees.end());
+    return subtrees;
+}
+
+void SceneBuilder::buildInto(Node& parent, int count, const SubtreeFunction& build, SceneChangeLog* log) const
+{
+    parent.addChildren(this->build(count, build), log);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "node.h"
+#include <functional>
+#include <vector>
+
+// Builds large scene graphs on several threads. The caller describes the graph as
+// independent subtrees; each is built detached from the scene, where adding children
+// is reported to nobody, and the finished subtrees are attached with a single
+// Node::addChildren: one change per subtree, which the Tree Widget applies in one batch.
+//
+// The build function runs on worker threads at the same time. Nodes, names
+// (NameTable) and shared polygons (GeometryRef) may be used from there, but
+// GeometryRegistry may not: look up the polygons the subtrees draw beforehand.
+class SceneBuilder
+{
+public:
+    // Builds subtree number index, given the number of subtrees being built
+    typedef std::function<uPtr<Node>(int index, int count)> SubtreeFunction;
+
+    // threadCount workers build the subtrees; 0 uses one per hardware thread
+    explicit SceneBuilder(unsigned int threadCount = 0);
+
+    // Calls build for every index in [0, count) and returns the subtrees in index order,
+    // leaving out those build returned nullptr for
+    std::vector<uPtr<Node>> build(int count, const SubtreeFunction& build) const;
+    // Builds count subtrees like build() and adds them all to parent at once.
+    // Pass the scene's SceneChangeLog if parent is in a scene that is being shown.
+    void buildInto(Node& parent, int count, const SubtreeFunction& build, SceneChangeLog* log = nullptr) const;
+
+private:
+    unsigned int m_threadCount;
+};
@@ -0,0 +1,94 @@
+#include "scenechangelog.h"
+#include "node.h"
+#include <algorithm>
+
+SceneChangeLog::SceneChangeLog()
+    : m_pending(), m_changed(), m_removed(), m_notify()
+{}
+
+void SceneChangeLog::setNotify(std::function<void()> notify)
+{
+    m_notify = std::move(notify);
+}
+
+void SceneChangeLog::nodeAdded(Node* node, Node* parent)
+{
+    // The node was detached earlier in this batch; its Removed change is the last one about it
+    auto removed = m_removed.find(node);
+    if (removed != m_removed.end()) {
+        SceneChange& change = m_pending[removed->second];
+        Node* oldParent = change.parent;
+        change.node = nullptr;
+        m_removed.erase(removed);
+        m_changed[node] = append({SceneChange::Kind::Reparented, node, parent, oldParent});
+        return;
+    }
+    m_changed[node] = append({SceneChange::Kind::Added, node, parent, nullptr});
+}
+
+void SceneChangeLog::nodeRemoved(Node* node, Node* parent)
+{
+    // Whatever was recorded about the subtree is only kept as a Removed key
+    dropInside(node);
+    m_removed[node] = append({SceneChange::Kind::Removed, node, parent, nullptr});
+}
+
+void SceneChangeLog::nodeRenamed(Node* node)
+{
+    if (m_changed.count(node)) {
+        return;
+    }
+    m_changed[node] = append({SceneChange::Kind::Renamed, node, node->getParent(), nullptr});
+}
+
+SceneChangeBatch SceneChangeLog::take()
+{
+    SceneChangeBatch batch;
+    batch.swap(m_pending);
+    batch.erase(std::remove_if(batch.begin(), batch.end(), [](const SceneChange& c) { return !c.node; }),
+                batch.end());
+    m_changed.clear();
+    m_removed.clear();
+    return batch;
+}
+
+bool SceneChangeLog::empty() const
+{
+    return m_changed.empty() && m_removed.empty();
+}
+
+std::size_t SceneChangeLog::append(const SceneChange& change)
+{
+    // Dropped changes stay in m_pending until take(), so a notify is already under way
+    bool wasEmpty = m_pending.empty();
+    m_pending.push_back(change);
+    if (wasEmpty && m_notify) {
+        m_notify();
+    }
+    return m_pending.size() - 1;
+}
+
+void SceneChangeLog::dropInside(const Node* node)
+{
+    // Nothing pending to drop is the common case, e.g. deleting a large subtree
+    // that was loaded earlier, and costs nothing
+    std::vector<const Node*> stack;
+    if (!m_changed.empty()) {
+        stack.push_back(node);
+    }
+    while (!stack.empty()) {
+        const Node* n = stack.back();
+        stack.pop_back();
+        auto it = m_changed.find(n);
+        if (it != m_changed.end()) {
+            m_pending[it->second].node = nullptr;
+            m_changed.erase(it);
+            if (m_changed.empty()) {
+                break;
+            }
+        }
+        for (const uPtr<Node>& child : n->getChildren()) {
+            stack.push_back(child.get());
+        }
+    }
+}
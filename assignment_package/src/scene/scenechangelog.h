@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+class Node;
+
+// One structural change to a scene graph
+struct SceneChange {
+    enum class Kind : unsigned char {
+        Added,      // node, with its whole subtree, became the last child of parent
+        Removed,    // node left parent. It may be destroyed by the time the change is read,
+                    // so it is only good for looking up what was built for it.
+        Renamed,    // node's name changed
+        Reparented  // node, with its subtree, moved from oldParent to be the last child of parent
+    };
+    Kind kind;
+    Node* node;
+    Node* parent;
+    Node* oldParent; // Only for Kind::Reparented
+};
+
+typedef std::vector<SceneChange> SceneChangeBatch;
+
+// Collects the structural changes of a scene graph so a view of it (the Tree Widget)
+// can catch up in batches, touching only the affected rows, instead of being rebuilt.
+// The scene's owner passes it to the addChild, addChildren, removeChild and setName calls
+// it makes on the scene, which record themselves. Changes are merged as they arrive:
+// - a node added and removed again before take() leaves only the removal, and the
+//   changes recorded for anything inside the removed subtree are dropped, so take()
+//   never returns a change about a node that no longer exists (except as Removed);
+// - a node removed and added again becomes one Reparented change;
+// - a rename of a node that is already added, moved or renamed in the batch is dropped,
+//   as the row made for that change shows the current name.
+// Pending changes are indexed by node, so each edit costs about O(1) and a removal
+// only visits the removed subtree, and only while changes are pending.
+// Not thread safe: only the thread that owns the displayed scene may edit it.
+class SceneChangeLog
+{
+public:
+    SceneChangeLog();
+
+    // Called whenever a change arrives while none are pending, e.g. to schedule a take()
+    void setNotify(std::function<void()> notify);
+
+    void nodeAdded(Node* node, Node* parent);
+    void nodeRemoved(Node* node, Node* parent);
+    void nodeRenamed(Node* node);
+
+    // Hands out the pending changes in the order they happened and starts a new batch
+    SceneChangeBatch take();
+    bool empty() const;
+
+private:
+    // Appends change and returns its index in m_pending
+    std::size_t append(const SceneChange& change);
+    // Drops the pending changes (other than Removed) about node and its subtree
+    void dropInside(const Node* node);
+
+    // In order. Dropped changes are left with a null node until take() compacts them.
+    SceneChangeBatch m_pending;
+    // Index in m_pending of the one change that isn't Removed pending about each node.
+    // A second one can't arise: a node only changes parent by being removed first,
+    // which drops its change, and a rename is dropped while it has one.
+    std::unordered_map<const Node*, std::size_t> m_changed;
+    // Index in m_pending of the Removed change of each node removed in this batch
+    std::unordered_map<const Node*, std::size_t> m_removed;
+    std::function<void()> m_notify;
+};
@@ -0,0 +1,150 @@
+#include "scenefile.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+// Reads a [r, g, b] or [x, y] list of numbers into the first count components of out
+static bool readNumbers(const QJsonValue& value, int count, float* out)
+{
+    QJsonArray array = value.toArray();
+    if (!value.isArray() || array.size() != count) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!array[i].isDouble()) {
+            return false;
+        }
+        out[i] = float(array[i].toDouble());
+    }
+    return true;
+}
+
+// Returns the shape described by a node's "geometry" value, or nullptr if it isn't valid
+static Polygon2D* readGeometry(const QJsonValue& value, GeometryRegistry& geometry)
+{
+    if (value.isDouble()) {
+        int sides = value.toInt();
+        return sides >= 3 ? geometry.regularPolygon(sides) : nullptr;
+    }
+    QJsonArray outline = value.toArray();
+    if (!value.isArray() || outline.size() < 3) {
+        return nullptr;
+    }
+    std::vector<glm::vec3> positions;
+    positions.reserve(outline.size());
+    for (const QJsonValue& point : outline) {
+        float xy[2];
+        if (!readNumbers(point, 2, xy)) {
+            return nullptr;
+        }
+        positions.push_back(glm::vec3(xy[0], xy[1], 1.f));
+    }
+    return geometry.polygon(positions);
+}
+
+// Builds one node without its children. Returns nullptr and sets error if object isn't a valid node.
+static uPtr<Node> readNode(const QJsonObject& object, GeometryRegistry& geometry, QString& error)
+{
+    QString type = object.value("type").toString("plain");
+    QString name = object.value("name").toString(type);
+    uPtr<Node> node;
+    if (type == "plain") {
+        node = mkU<Node>(name);
+    } else if (type == "translate") {
+        node = mkU<TranslateNode>(name, float(object.value("tx").toDouble(0.0)), float(object.value("ty").toDouble(0.0)));
+    } else if (type == "rotate") {
+        node = mkU<RotateNode>(name, float(object.value("angle").toDouble(0.0)));
+    } else if (type == "scale") {
+        node = mkU<ScaleNode>(name, float(object.value("sx").toDouble(1.0)), float(object.value("sy").toDouble(1.0)));
+    } else {
+        error = QString("node \"%1\" has unknown type \"%2\"").arg(name, type);
+        return nullptr;
+    }
+
+    if (object.contains("color")) {
+        glm::vec3 color;
+        if (!readNumbers(object.value("color"), 3, &color[0])) {
+            error = QString("node \"%1\" has an invalid color").arg(name);
+            return nullptr;
+        }
+        node->setColor(color);
+    }
+    if (object.contains("geometry")) {
+        Polygon2D* polygon = readGeometry(object.value("geometry"), geometry);
+        if (!polygon) {
+            error = QString("node \"%1\" has invalid geometry").arg(name);
+            return nullptr;
+        }
+        node->setGeometry(polygon);
+    }
+    return node;
+}
+
+uPtr<Node> SceneFile::read(const QString& path, GeometryRegistry& geometry, QString* error)
+{
+    QFile file(path);
+    if (!file.open(QFile::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return nullptr;
+    }
+    return parse(file.readAll(), geometry, error);
+}
+
+uPtr<Node> SceneFile::parse(const QByteArray& json, GeometryRegistry& geometry, QString* error)
+{
+    QString message;
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    QJsonValue rootValue = document.object().value("root");
+
+    uPtr<Node> root;
+    if (parseError.error != QJsonParseError::NoError) {
+        message = parseError.errorString();
+    } else if (!rootValue.isObject()) {
+        message = "no \"root\" node";
+    } else {
+        root = readNode(rootValue.toObject(), geometry, message);
+    }
+
+    // Build the children with an explicit stack rather than recursion, like Node's copies,
+    // so deep scenes can't overflow the call stack. Each pair is (JSON node, Node built from it).
+    std::vector<std::pair<QJsonObject, Node*>> stack;
+    if (root) {
+        stack.emplace_back(rootValue.toObject(), root.get());
+    }
+    while (!stack.empty()) {
+        QJsonObject object = stack.back().first;
+        Node* node = stack.back().second;
+        stack.pop_back();
+
+        // All of a node's children are attached at once, once they are all read
+        QJsonArray childValues = object.value("children").toArray();
+        std::vector<uPtr<Node>> children;
+        children.reserve(childValues.size());
+        for (const QJsonValue& childValue : childValues) {
+            uPtr<Node> child = childValue.isObject() ? readNode(childValue.toObject(), geometry, message) : nullptr;
+            if (!child) {
+                if (message.isEmpty()) {
+                    message = QString("a child of \"%1\" is not an object").arg(node->getName());
+                }
+                break;
+            }
+            stack.emplace_back(childValue.toObject(), child.get());
+            children.push_back(std::move(child));
+        }
+        if (children.size() < std::size_t(childValues.size())) {
+            root = nullptr;
+            stack.clear();
+            break;
+        }
+        node->addChildren(std::move(children));
+    }
+
+    if (!root && error) {
+        *error = message;
+    }
+    return root;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <smartpointerhelp.h>
+#include "node.h"
+#include "geometryregistry.h"
+
+// Reads scene graphs saved as JSON. A file holds one object with a "root" node:
+//   { "root": node }
+// and every node is an object like
+//   { "type": "translate", "name": "Arm", "tx": 0.4, "ty": 0,
+//     "color": [0, 0, 1], "geometry": 4, "children": [ node, ... ] }
+// "type" is one of "plain", "translate" (with "tx", "ty"), "rotate" (with "angle",
+// in degrees) or "scale" (with "sx", "sy"). "geometry" is optional and is either a
+// number of sides for a regular polygon, or an outline as a list of [x, y] points.
+// Missing values default to 0, black or 1 for scales.
+class SceneFile
+{
+public:
+    // Reads the scene stored in path, registering its shapes in geometry.
+    // Returns nullptr and describes the problem in error if the file can't be read or isn't a scene.
+    static uPtr<Node> read(const QString& path, GeometryRegistry& geometry, QString* error = nullptr);
+    // Same as read(), from the file's contents
+    static uPtr<Node> parse(const QByteArray& json, GeometryRegistry& geometry, QString* error = nullptr);
+};
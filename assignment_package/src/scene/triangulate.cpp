@@ -0,0 +1,465 @@
+#include "triangulate.h"
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+// Outlines with at most this many vertices are ear-clipped. Ear clipping is
+// O(n^2) but has less overhead than the sweep, so it wins on small input.
+const static std::size_t EAR_CLIPPING_MAX_VERTICES = 128;
+
+namespace {
+
+struct Point {
+    double x;
+    double y;
+};
+
+// Twice the signed area of triangle abc; positive if it turns counter-clockwise
+double cross(const Point& a, const Point& b, const Point& c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// Order in which the sweep line meets vertices: top to bottom, left to right on ties
+bool above(const Point& a, const Point& b)
+{
+    return a.y > b.y || (a.y == b.y && a.x < b.x);
+}
+
+// Works on the polygon with repeated points removed, in counter-clockwise order.
+// Triangles are written as indices into the caller's positions through ids.
+class Triangulator
+{
+public:
+    Triangulator(const std::vector<Point>& points, const std::vector<std::uint32_t>& ids,
+                 std::vector<std::uint32_t>& out)
+        : m_pts(points), m_ids(ids), m_out(out)
+    {}
+
+    // Adds triangle abc (given as indices into m_pts), skipping it if it has no area
+    void addTriangle(int a, int b, int c)
+    {
+        double area = cross(m_pts[a], m_pts[b], m_pts[c]);
+        if (area == 0.0) {
+            return;
+        }
+        if (area < 0.0) {
+            std::swap(b, c);
+        }
+        m_out.push_back(m_ids[a]);
+        m_out.push_back(m_ids[b]);
+        m_out.push_back(m_ids[c]);
+    }
+
+    bool isConvex() const;
+    void fan();
+    void earClip();
+    // Returns false without emitting anything if the input turned out not to be simple
+    bool monotone();
+
+private:
+    void triangulateMonotonePiece(const std::vector<int>& piece);
+
+    const std::vector<Point>& m_pts;
+    const std::vector<std::uint32_t>& m_ids;
+    std::vector<std::uint32_t>& m_out;
+};
+
+bool Triangulator::isConvex() const
+{
+    int n = m_pts.size();
+    for (int i = 0; i < n; i++) {
+        if (cross(m_pts[(i + n - 1) % n], m_pts[i], m_pts[(i + 1) % n]) < 0.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Triangulator::fan()
+{
+    for (int i = 1; i + 1 < int(m_pts.size()); i++) {
+        addTriangle(0, i, i + 1);
+    }
+}
+
+void Triangulator::earClip()
+{
+    int n = m_pts.size();
+    std::vector<int> prev(n), next(n);
+    for (int i = 0; i < n; i++) {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+    }
+
+    auto isEar = [&](int b) {
+        int a = prev[b], c = next[b];
+        if (cross(m_pts[a], m_pts[b], m_pts[c]) <= 0.0) {
+            return false;
+        }
+        // Only reflex vertices can lie inside a convex corner's triangle
+        for (int v = next[c]; v != a; v = next[v]) {
+            const Point& p = m_pts[v];
+            if (cross(m_pts[prev[v]], p, m_pts[next[v]]) > 0.0) {
+                continue;
+            }
+            bool atCorner = (p.x == m_pts[a].x && p.y == m_pts[a].y)
+                    || (p.x == m_pts[c].x && p.y == m_pts[c].y);
+            if (!atCorner && cross(m_pts[a], m_pts[b], p) >= 0.0
+                    && cross(m_pts[b], m_pts[c], p) >= 0.0
+                    && cross(m_pts[c], m_pts[a], p) >= 0.0) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int remaining = n;
+    int v = 0;
+    int misses = 0;
+    while (remaining > 3) {
+        if (isEar(v)) {
+            addTriangle(prev[v], v, next[v]);
+        } else if (++misses <= remaining) {
+            v = next[v];
+            continue;
+        } else if (cross(m_pts[prev[v]], m_pts[v], m_pts[next[v]]) != 0.0) {
+            // A whole lap without an ear: the outline crosses itself.
+            // Clip anyway so that something close to the input is drawn.
+            addTriangle(prev[v], v, next[v]);
+        }
+        // (A corner with no area is dropped without a triangle)
+        next[prev[v]] = next[v];
+        prev[next[v]] = prev[v];
+        v = next[v];
+        remaining--;
+        misses = 0;
+    }
+    addTriangle(prev[v], v, next[v]);
+}
+
+bool Triangulator::monotone()
+{
+    // Split the polygon into y-monotone pieces by adding diagonals at split and merge
+    // vertices (de Berg et al., Computational Geometry, ch. 3), then triangulate each piece.
+    enum class Kind : unsigned char { Start, End, Split, Merge, Regular };
+
+    int n = m_pts.size();
+    auto prevOf = [n](int i) { return (i + n - 1) % n; };
+    auto nextOf = [n](int i) { return (i + 1) % n; };
+
+    std::vector<Kind> kind(n);
+    std::vector<int> order(n);
+    for (int i = 0; i < n; i++) {
+        const Point& p = m_pts[i];
+        bool prevBelow = above(p, m_pts[prevOf(i)]);
+        bool nextBelow = above(p, m_pts[nextOf(i)]);
+        bool convex = cross(m_pts[prevOf(i)], p, m_pts[nextOf(i)]) > 0.0;
+        if (prevBelow && nextBelow) {
+            kind[i] = convex ? Kind::Start : Kind::Split;
+        } else if (!prevBelow && !nextBelow) {
+            kind[i] = convex ? Kind::End : Kind::Merge;
+        } else {
+            kind[i] = Kind::Regular;
+        }
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(),
+              [this](int a, int b) { return above(m_pts[a], m_pts[b]); });
+
+    // Edge i runs from vertex i to vertex i + 1. The sweep status holds the edges
+    // with the polygon's interior to their right, ordered by where they cross the sweep line.
+    double sweepY = 0.0;
+    auto xAt = [this, &sweepY, &nextOf](int e) {
+        const Point& a = m_pts[e];
+        const Point& b = m_pts[nextOf(e)];
+        if (a.y == b.y) {
+            // Horizontal edges only share the sweep line with their own endpoints
+            return std::max(a.x, b.x);
+        }
+        return a.x + (sweepY - a.y) / (b.y - a.y) * (b.x - a.x);
+    };
+    struct EdgeLess {
+        decltype(xAt)& edgeX;
+        using is_transparent = void;
+        bool operator()(int a, int b) const { return edgeX(a) < edgeX(b); }
+        bool operator()(int a, double x) const { return edgeX(a) < x; }
+        bool operator()(double x, int b) const { return x < edgeX(b); }
+    };
+    using Status = std::set<int, EdgeLess>;
+    Status status(EdgeLess{xAt});
+    std::vector<Status::iterator> inStatus(n, status.end());
+    std::vector<int> helper(n, -1);
+    std::vector<std::pair<int, int>> diagonals;
+
+    auto insert = [&](int e, int v) {
+        inStatus[e] = status.insert(e).first;
+        helper[e] = v;
+    };
+    // Removes the edge ending at v, first connecting v to the edge's helper if that is a merge vertex
+    auto finish = [&](int e, int v) {
+        if (inStatus[e] == status.end()) {
+            return false;
+        }
+        if (kind[helper[e]] == Kind::Merge) {
+            diagonals.emplace_back(v, helper[e]);
+        }
+        status.erase(inStatus[e]);
+        inStatus[e] = status.end();
+        return true;
+    };
+    // Finds the edge directly left of v and makes v its helper
+    auto leftOf = [&](int v, bool connectToMerge) {
+        auto it = status.lower_bound(m_pts[v].x);
+        if (it == status.begin()) {
+            return false;
+        }
+        int e = *std::prev(it);
+        if (!connectToMerge || kind[helper[e]] == Kind::Merge) {
+            diagonals.emplace_back(v, helper[e]);
+        }
+        helper[e] = v;
+        return true;
+    };
+
+    for (int v : order) {
+        sweepY = m_pts[v].y;
+        int ePrev = prevOf(v);
+        bool ok = true;
+        switch (kind[v]) {
+        case Kind::Start:
+            insert(v, v);
+            break;
+        case Kind::End:
+            ok = finish(ePrev, v);
+            break;
+        case Kind::Split:
+            ok = leftOf(v, false);
+            insert(v, v);
+            break;
+        case Kind::Merge:
+            ok = finish(ePrev, v) && leftOf(v, true);
+            break;
+        case Kind::Regular:
+            if (above(m_pts[ePrev], m_pts[v])) {
+                // Going down the left side of the interior
+                ok = finish(ePrev, v);
+                insert(v, v);
+            } else {
+                ok = leftOf(v, true);
+            }
+            break;
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+
+    // Walk the faces the diagonals cut the polygon into. At every vertex, the
+    // neighbours are sorted counter-clockwise; arriving from u, the face continues
+    // with the neighbour just clockwise of u.
+    std::vector<std::vector<int>> nbrs(n);
+    for (int i = 0; i < n; i++) {
+        nbrs[i] = {prevOf(i), nextOf(i)};
+    }
+    for (const std::pair<int, int>& d : diagonals) {
+        nbrs[d.first].push_back(d.second);
+        nbrs[d.second].push_back(d.first);
+    }
+    for (int i = 0; i < n; i++) {
+        if (nbrs[i].size() > 2) {
+            const Point& c = m_pts[i];
+            std::sort(nbrs[i].begin(), nbrs[i].end(), [&](int a, int b) {
+                return std::atan2(m_pts[a].y - c.y, m_pts[a].x - c.x)
+                        < std::atan2(m_pts[b].y - c.y, m_pts[b].x - c.x);
+            });
+        }
+    }
+
+    std::vector<std::vector<bool>> used(n);
+    for (int i = 0; i < n; i++) {
+        used[i].assign(nbrs[i].size(), false);
+    }
+    auto slot = [&](int from, int to) {
+        return int(std::find(nbrs[from].begin(), nbrs[from].end(), to) - nbrs[from].begin());
+    };
+
+    std::size_t triangleCount = m_out.size();
+    std::vector<int> piece;
+    for (int start = 0; start < n; start++) {
+        for (std::size_t k = 0; k < nbrs[start].size(); k++) {
+            // Going backwards along the outline would walk around the outside
+            if (used[start][k] || nbrs[start][k] == prevOf(start)) {
+                continue;
+            }
+            piece.clear();
+            int from = start, at = k;
+            while (!used[from][at]) {
+                used[from][at] = true;
+                piece.push_back(from);
+                int to = nbrs[from][at];
+                int back = slot(to, from);
+                int count = nbrs[to].size();
+                at = (back + count - 1) % count;
+                from = to;
+            }
+            if (piece.size() < 3 || from != start) {
+                m_out.resize(triangleCount);
+                return false;
+            }
+            triangulateMonotonePiece(piece);
+        }
+    }
+    return true;
+}
+
+void Triangulator::triangulateMonotonePiece(const std::vector<int>& piece)
+{
+    int k = piece.size();
+    if (k == 3) {
+        addTriangle(piece[0], piece[1], piece[2]);
+        return;
+    }
+
+    int top = 0, bottom = 0;
+    for (int i = 1; i < k; i++) {
+        if (above(m_pts[piece[i]], m_pts[piece[top]])) top = i;
+        if (above(m_pts[piece[bottom]], m_pts[piece[i]])) bottom = i;
+    }
+
+    // Merge the two chains from top to bottom. Going counter-clockwise from
+    // the top vertex walks down the left chain.
+    struct Entry {
+        int v;
+        bool left;
+    };
+    std::vector<Entry> sorted;
+    sorted.reserve(k);
+    sorted.push_back({piece[top], true});
+    int l = (top + 1) % k, r = (top + k - 1) % k;
+    while (l != bottom || r != bottom) {
+        if (r == bottom || (l != bottom && above(m_pts[piece[l]], m_pts[piece[r]]))) {
+            sorted.push_back({piece[l], true});
+            l = (l + 1) % k;
+        } else {
+            sorted.push_back({piece[r], false});
+            r = (r + k - 1) % k;
+        }
+    }
+    sorted.push_back({piece[bottom], true});
+
+    std::vector<Entry> stack = {sorted[0], sorted[1]};
+    for (int j = 2; j < k - 1; j++) {
+        const Entry& u = sorted[j];
+        if (u.left != stack.back().left) {
+            // u sees every vertex on the stack
+            while (stack.size() > 1) {
+                Entry a = stack.back();
+                stack.pop_back();
+                addTriangle(u.v, a.v, stack.back().v);
+            }
+            stack = {sorted[j - 1], u};
+        } else {
+            Entry last = stack.back();
+            stack.pop_back();
+            while (!stack.empty()) {
+                double turn = cross(m_pts[stack.back().v], m_pts[last.v], m_pts[u.v]);
+                if (u.left ? turn <= 0.0 : turn >= 0.0) {
+                    break;
+                }
+                addTriangle(stack.back().v, last.v, u.v);
+                last = stack.back();
+                stack.pop_back();
+            }
+            stack.push_back(last);
+            stack.push_back(u);
+        }
+    }
+    int b = sorted[k - 1].v;
+    while (stack.size() > 1) {
+        Entry a = stack.back();
+        stack.pop_back();
+        addTriangle(b, a.v, stack.back().v);
+    }
+}
+
+// Copies positions into points / ids in counter-clockwise order, leaving out repeated points.
+// Returns false if fewer than three distinct points remain or the outline has no area.
+bool prepare(const std::vector<glm::vec3>& positions, std::vector<Point>& points,
+             std::vector<std::uint32_t>& ids)
+{
+    points.reserve(positions.size());
+    ids.reserve(positions.size());
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        Point p{positions[i].x, positions[i].y};
+        if (!points.empty() && points.back().x == p.x && points.back().y == p.y) {
+            continue;
+        }
+        points.push_back(p);
+        ids.push_back(i);
+    }
+    while (points.size() > 1 && points.back().x == points.front().x
+           && points.back().y == points.front().y) {
+        points.pop_back();
+        ids.pop_back();
+    }
+    if (points.size() < 3) {
+        return false;
+    }
+
+    double area = 0.0;
+    for (std::size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+        area += points[j].x * points[i].y - points[i].x * points[j].y;
+    }
+    if (area == 0.0) {
+        return false;
+    }
+    if (area < 0.0) {
+        std::reverse(points.begin(), points.end());
+        std::reverse(ids.begin(), ids.end());
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<std::uint32_t> triangulate(const std::vector<glm::vec3>& positions)
+{
+    std::vector<std::uint32_t> indices;
+    std::vector<Point> points;
+    std::vector<std::uint32_t> ids;
+    if (!prepare(positions, points, ids)) {
+        return indices;
+    }
+    indices.reserve(3 * (points.size() - 2));
+
+    Triangulator t(points, ids, indices);
+    if (t.isConvex()) {
+        t.fan();
+    } else if (points.size() <= EAR_CLIPPING_MAX_VERTICES || !t.monotone()) {
+        t.earClip();
+    }
+    return indices;
+}
+
+std::vector<std::uint32_t> triangulateEarClipping(const std::vector<glm::vec3>& positions)
+{
+    std::vector<std::uint32_t> indices;
+    std::vector<Point> points;
+    std::vector<std::uint32_t> ids;
+    if (prepare(positions, points, ids)) {
+        Triangulator(points, ids, indices).earClip();
+    }
+    return indices;
+}
+
+std::vector<std::uint32_t> triangulateMonotone(const std::vector<glm::vec3>& positions)
+{
+    std::vector<std::uint32_t> indices;
+    std::vector<Point> points;
+    std::vector<std::uint32_t> ids;
+    if (prepare(positions, points, ids)) {
+        Triangulator(points, ids, indices).monotone();
+    }
+    return indices;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <la.h>
+#include <cstdint>
+#include <vector>
+
+// Splits a simple polygon (no self-intersections, any winding order, convex or not)
+// into triangles. Only the x and y components of the positions are used.
+// Returns the triangles' vertex indices into positions, three per triangle,
+// each triangle in counter-clockwise order.
+// Convex input is fanned in O(n). Small outlines are ear-clipped, and large ones
+// are split into y-monotone pieces by a sweep line, which takes O(n log n).
+std::vector<std::uint32_t> triangulate(const std::vector<glm::vec3>& positions);
+
+// The two triangulators triangulate() chooses between, exposed for benchmarking.
+// Both expect positions to already be in counter-clockwise order without repeated points.
+std::vector<std::uint32_t> triangulateEarClipping(const std::vector<glm::vec3>& positions);
+std::vector<std::uint32_t> triangulateMonotone(const std::vector<glm::vec3>& positions);
@@ -0,0 +1,219 @@
+#include "scenetree.h"
+#include <algorithm>
+
+namespace {
+// A row of the widget: the node it shows and whether its children have rows yet
+class NodeItem : public QTreeWidgetItem
+{
+public:
+    explicit NodeItem(Node* node) : QTreeWidgetItem(), mp_node(node), m_populated(false) {}
+
+    Node* mp_node;
+    bool m_populated;
+};
+}
+
+SceneTree::SceneTree(QTreeWidget* widget, QObject* parent)
+    : QObject(parent), mp_widget(widget), mp_root(nullptr), m_items()
+{
+    connect(mp_widget, SIGNAL(itemExpanded(QTreeWidgetItem*)),
+            this, SLOT(slot_populate(QTreeWidgetItem*)));
+}
+
+void SceneTree::setRoot(Node* root)
+{
+    mp_widget->clear();
+    m_items.clear();
+    mp_root = root;
+    if (root) {
+        mp_widget->addTopLevelItem(makeItem(root));
+    }
+}
+
+Node* SceneTree::nodeOf(QTreeWidgetItem* item)
+{
+    return item ? static_cast<NodeItem*>(item)->mp_node : nullptr;
+}
+
+QTreeWidgetItem* SceneTree::itemFor(Node* node)
+{
+    if (!node) {
+        return nullptr;
+    }
+    std::vector<Node*> path;
+    for (Node* n = node; n; n = n->getParent()) {
+        path.push_back(n);
+    }
+    if (path.back() != mp_root) {
+        return nullptr;
+    }
+    // Down from the root, making each level's rows on the way
+    QTreeWidgetItem* item = m_items.value(mp_root);
+    for (auto it = path.rbegin() + 1; it != path.rend(); ++it) {
+        populate(item);
+        item = m_items.value(*it);
+    }
+    return item;
+}
+
+std::vector<Node*> SceneTree::selectedNodes() const
+{
+    QList<QTreeWidgetItem*> items = mp_widget->selectedItems();
+    std::vector<Node*> nodes;
+    nodes.reserve(items.size());
+    for (QTreeWidgetItem* item : items) {
+        nodes.push_back(nodeOf(item));
+    }
+    return nodes;
+}
+
+int SceneTree::rowCount() const
+{
+    return m_items.size();
+}
+
+void SceneTree::slot_applyChanges(const SceneChangeBatch& changes)
+{
+    // Consecutive additions to the same row are inserted together
+    QTreeWidgetItem* addingTo = nullptr;
+    QList<QTreeWidgetItem*> adding;
+    auto insertAdded = [&]() {
+        if (addingTo && !adding.isEmpty()) {
+            addingTo->addChildren(adding);
+        }
+        addingTo = nullptr;
+        adding.clear();
+    };
+    // A node gained a child: give it a row if its parent's children have rows,
+    // or else just let its parent's row show that it can be expanded.
+    // A row expanded since the change was made already shows the child.
+    auto added = [&](Node* node, Node* parent) {
+        QTreeWidgetItem* parentItem = m_items.value(parent);
+        if (!parentItem || m_items.contains(node)) {
+            return;
+        }
+        if (!isPopulated(parentItem)) {
+            parentItem->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+            return;
+        }
+        if (parentItem != addingTo) {
+            insertAdded();
+            addingTo = parentItem;
+        }
+        adding.append(makeItem(node));
+    };
+
+    mp_widget->setUpdatesEnabled(false);
+    for (const SceneChange& change : changes) {
+        if (change.kind != SceneChange::Kind::Added) {
+            insertAdded();
+        }
+        // Removed nodes may be gone; they are only used as keys
+        QTreeWidgetItem* item = m_items.value(change.node);
+        switch (change.kind) {
+        case SceneChange::Kind::Added:
+            added(change.node, change.parent);
+            break;
+        case SceneChange::Kind::Removed:
+            if (item) {
+                removeItem(item);
+            }
+            break;
+        case SceneChange::Kind::Renamed:
+            if (item) {
+                item->setText(0, change.node->getName());
+            }
+            break;
+        case SceneChange::Kind::Reparented: {
+            QTreeWidgetItem* parentItem = m_items.value(change.parent);
+            if (item && parentItem && isPopulated(parentItem)) {
+                // Keep the row, and whether it was open. The node may be a new one at a
+                // removed node's address, so its text and child rows are made afresh.
+                bool expanded = item->isExpanded();
+                item->parent()->removeChild(item);
+                clearChildren(item);
+                item->setText(0, change.node->getName());
+                parentItem->addChild(item);
+                if (expanded) {
+                    populate(item);
+                    item->setExpanded(true);
+                }
+            } else {
+                if (item) {
+                    removeItem(item);
+                }
+                added(change.node, change.parent);
+            }
+            break;
+        }
+        }
+    }
+    insertAdded();
+    mp_widget->setUpdatesEnabled(true);
+}
+
+void SceneTree::slot_populate(QTreeWidgetItem* item)
+{
+    populate(item);
+}
+
+QTreeWidgetItem* SceneTree::makeItem(Node* node)
+{
+    NodeItem* item = new NodeItem(node);
+    item->setText(0, node->getName());
+    if (!node->getChildren().empty()) {
+        item->setChildIndicatorPolicy(QTreeWidgetItem::ShowIndicator);
+    }
+    m_items.insert(node, item);
+    return item;
+}
+
+void SceneTree::populate(QTreeWidgetItem* item)
+{
+    NodeItem* nodeItem = static_cast<NodeItem*>(item);
+    if (nodeItem->m_populated) {
+        return;
+    }
+    const Node::ChildList& children = nodeItem->mp_node->getChildren();
+    QList<QTreeWidgetItem*> items;
+    items.reserve(children.size());
+    for (const uPtr<Node>& child : children) {
+        items.append(makeItem(child.get()));
+    }
+    item->addChildren(items);
+    item->setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicatorWhenChildless);
+    nodeItem->m_populated = true;
+}
+
+void SceneTree::clearChildren(QTreeWidgetItem* item)
+{
+    QList<QTreeWidgetItem*> children = item->takeChildren();
+    for (QTreeWidgetItem* child : children) {
+        removeItem(child);
+    }
+    NodeItem* nodeItem = static_cast<NodeItem*>(item);
+    nodeItem->m_populated = false;
+    item->setChildIndicatorPolicy(nodeItem->mp_node->getChildren().empty()
+                                  ? QTreeWidgetItem::DontShowIndicatorWhenChildless
+                                  : QTreeWidgetItem::ShowIndicator);
+}
+
+void SceneTree::removeItem(QTreeWidgetItem* item)
+{
+    // Forget the rows below item, which go with it
+    std::vector<QTreeWidgetItem*> stack = {item};
+    while (!stack.empty()) {
+        QTreeWidgetItem* i = stack.back();
+        stack.pop_back();
+        m_items.remove(nodeOf(i));
+        for (int c = 0; c < i->childCount(); c++) {
+            stack.push_back(i->child(c));
+        }
+    }
+    delete item;
+}
+
+bool SceneTree::isPopulated(QTreeWidgetItem* item)
+{
+    return static_cast<NodeItem*>(item)->m_populated;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QTreeWidget>
+#include <vector>
+#include "scene/node.h"
+
+// Shows a scene graph in a QTreeWidget. Rows are only made for the root and the
+// children of rows that have been expanded, so a scene of millions of nodes costs
+// about as many rows as are on screen. Edits of the scene arrive as SceneChangeBatches
+// and only touch the rows of the nodes they concern.
+class SceneTree : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SceneTree(QTreeWidget* widget, QObject* parent = nullptr);
+
+    // Shows the scene under root, replacing whatever was shown. nullptr shows nothing.
+    void setRoot(Node* root);
+
+    // The node a row of the widget stands for
+    static Node* nodeOf(QTreeWidgetItem* item);
+    // The row of node, making the rows of its ancestors' children if they don't exist yet.
+    // nullptr if node isn't in the scene shown.
+    QTreeWidgetItem* itemFor(Node* node);
+    // The nodes of the selected rows, in selection order
+    std::vector<Node*> selectedNodes() const;
+
+    // Number of rows currently made
+    int rowCount() const;
+
+public slots:
+    // Brings the rows up to date with a batch of edits
+    void slot_applyChanges(const SceneChangeBatch& changes);
+
+private slots:
+    // Makes the rows of an expanded row's children
+    void slot_populate(QTreeWidgetItem* item);
+
+private:
+    // A new row for node, not yet inserted anywhere. Its children get rows when it is expanded.
+    QTreeWidgetItem* makeItem(Node* node);
+    // Makes the rows of all of item's children at once, unless they exist already
+    void populate(QTreeWidgetItem* item);
+    // Deletes the rows below item, leaving it to be populated again. Its node must exist.
+    void clearChildren(QTreeWidgetItem* item);
+    // Deletes item and the rows below it
+    void removeItem(QTreeWidgetItem* item);
+    // Whether the rows of item's children exist
+    static bool isPopulated(QTreeWidgetItem* item);
+
+    QTreeWidget* mp_widget;
+    Node* mp_root;
+    QHash<const Node*, QTreeWidgetItem*> m_items; // The row of every node that has one
+};
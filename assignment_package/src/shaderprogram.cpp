@@ -1,69 +1,185 @@
 #include "shaderprogram.h"
+#include "programbinarycache.h"
+#include "backgroundshadercompiler.h"
 #include <QFile>
+#include <QOpenGLContext>
+
+// From KHR_parallel_shader_compile, in case the GL headers predate it
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 
 ShaderProgram::ShaderProgram(OpenGLContext *context)
     : m_vertShader(), m_fragShader(), m_prog(),
-      m_attrPos(-1), m_attrCol(-1),
+      m_attrPos(-1), m_attrCol(-1), m_attrModel(-1),
       m_unifModel(-1), m_unifView(-1),
+      m_pendingVertShader(0), m_pendingFragShader(0), m_pendingProg(0),
+      m_parallelCompile(false), m_threadedCompile(false), mp_compiler(),
+      m_reloadVertSource(), m_reloadFragSource(),
       context(context)
 {}
 
+ShaderProgram::~ShaderProgram() = default;
+
 void ShaderProgram::create(const char *vertfile, const char *fragfile)
 {
-    // Allocate space on our GPU for a vertex shader and a fragment shader and a shader program to manage the two
-    m_vertShader = context->glCreateShader(GL_VERTEX_SHADER);
-    m_fragShader = context->glCreateShader(GL_FRAGMENT_SHADER);
+    // Allocate space on our GPU for a shader program
     m_prog = context->glCreateProgram();
     // Get the body of text stored in our two .glsl files
-    QString qVertSource = qTextFileRead(vertfile);
-    QString qFragSource = qTextFileRead(fragfile);
-
-    char* vertSource = new char[qVertSource.size()+1];
-    strcpy(vertSource, qVertSource.toStdString().c_str());
-    char* fragSource = new char[qFragSource.size()+1];
-    strcpy(fragSource, qFragSource.toStdString().c_str());
+    QByteArray vertSource = fileRead(vertfile);
+    QByteArray fragSource = fileRead(fragfile);
+
+    // Reuse the program linked by a previous launch if the sources and driver are unchanged
+    ProgramBinaryCache cache(context);
+    QByteArray key = cache.key(vertSource, fragSource);
+    bool cached = cache.load(key, m_prog);
+    if (!cached) {
+        cache.prepareForSave(m_prog);
+        compileAndLink(*context, vertSource, fragSource, m_prog, &m_vertShader, &m_fragShader);
+        if (checkLinked(m_prog, m_vertShader, m_fragShader)) {
+            cache.save(key, m_prog);
+        }
+    }
+    findLocations();
+
+    // Lets pollReload() check on a reload without stalling until it is done
+    QOpenGLContext* ctx = QOpenGLContext::currentContext();
+    m_parallelCompile = ctx && (ctx->hasExtension("GL_KHR_parallel_shader_compile")
+                                || ctx->hasExtension("GL_ARB_parallel_shader_compile"));
+    // Otherwise, a thread of its own can wait for the driver instead
+    m_threadedCompile = ctx && !m_parallelCompile && BackgroundShaderCompiler::isSupported();
+}
 
+void ShaderProgram::compileAndLink(QOpenGLFunctions_3_2_Core& gl, const QByteArray& vertSource, const QByteArray& fragSource,
+                                   GLuint prog, GLuint* vertShader, GLuint* fragShader)
+{
+    // Allocate space on our GPU for a vertex shader and a fragment shader
+    *vertShader = gl.glCreateShader(GL_VERTEX_SHADER);
+    *fragShader = gl.glCreateShader(GL_FRAGMENT_SHADER);
 
     // Send the shader text to OpenGL and store it in the shaders specified by the handles vertShader and fragShader
-    context->glShaderSource(m_vertShader, 1, &vertSource, 0);
-    context->glShaderSource(m_fragShader, 1, &fragSource, 0);
+    const char* vertText = vertSource.constData();
+    const char* fragText = fragSource.constData();
+    GLint vertLength = vertSource.size();
+    GLint fragLength = fragSource.size();
+    gl.glShaderSource(*vertShader, 1, &vertText, &vertLength);
+    gl.glShaderSource(*fragShader, 1, &fragText, &fragLength);
     // Tell OpenGL to compile the shader text stored above
-    context->glCompileShader(m_vertShader);
-    context->glCompileShader(m_fragShader);
+    gl.glCompileShader(*vertShader);
+    gl.glCompileShader(*fragShader);
+
+    // Tell prog that it manages these particular vertex and fragment shaders
+    gl.glAttachShader(prog, *vertShader);
+    gl.glAttachShader(prog, *fragShader);
+    gl.glLinkProgram(prog);
+}
+
+bool ShaderProgram::checkLinked(GLuint prog, GLuint vertShader, GLuint fragShader)
+{
     // Check if everything compiled OK
     GLint compiled;
-    context->glGetShaderiv(m_vertShader, GL_COMPILE_STATUS, &compiled);
+    context->glGetShaderiv(vertShader, GL_COMPILE_STATUS, &compiled);
     if (!compiled) {
-        printShaderInfoLog(m_vertShader);
+        printShaderInfoLog(vertShader);
     }
-    context->glGetShaderiv(m_fragShader, GL_COMPILE_STATUS, &compiled);
+    context->glGetShaderiv(fragShader, GL_COMPILE_STATUS, &compiled);
     if (!compiled) {
-        printShaderInfoLog(m_fragShader);
+        printShaderInfoLog(fragShader);
     }
 
-    // Tell prog that it manages these particular vertex and fragment shaders
-    context->glAttachShader(m_prog, m_vertShader);
-    context->glAttachShader(m_prog, m_fragShader);
-    context->glLinkProgram(m_prog);
-
     // Check for linking success
     GLint linked;
-    context->glGetProgramiv(m_prog, GL_LINK_STATUS, &linked);
+    context->glGetProgramiv(prog, GL_LINK_STATUS, &linked);
     if (!linked) {
-        printLinkInfoLog(m_prog);
+        printLinkInfoLog(prog);
     }
+    return linked;
+}
 
+void ShaderProgram::findLocations()
+{
     // Get the handles to the variables stored in our shaders
     // See shaderprogram.h for more information about these variables
 
     m_attrPos = context->glGetAttribLocation(m_prog, "vs_Pos");
     m_attrCol = context->glGetAttribLocation(m_prog, "vs_Col");
+    m_attrModel = context->glGetAttribLocation(m_prog, "vs_Model");
 
     m_unifModel      = context->glGetUniformLocation(m_prog, "u_Model");
     m_unifView   = context->glGetUniformLocation(m_prog, "u_View");
 }
 
+void ShaderProgram::beginReload(const QByteArray& vertSource, const QByteArray& fragSource)
+{
+    // A newer edit supersedes a reload that is still compiling
+    discardReload();
+    if (m_threadedCompile) {
+        if (!mp_compiler) {
+            mp_compiler = mkU<BackgroundShaderCompiler>(QOpenGLContext::currentContext());
+        }
+        mp_compiler->start(vertSource, fragSource);
+        m_reloadVertSource = vertSource;
+        m_reloadFragSource = fragSource;
+        return;
+    }
+    m_pendingProg = context->glCreateProgram();
+    compileAndLink(*context, vertSource, fragSource, m_pendingProg, &m_pendingVertShader, &m_pendingFragShader);
+}
+
+bool ShaderProgram::pollReload()
+{
+    if (mp_compiler && mp_compiler->takeResult(&m_pendingProg, &m_pendingVertShader, &m_pendingFragShader)
+            && !m_pendingProg) {
+        // The worker couldn't get a context, so this and later reloads are built here
+        qDebug() << "Shader reload: no worker thread context, compiling on the GUI thread";
+        m_threadedCompile = false;
+        mp_compiler.reset();
+        beginReload(m_reloadVertSource, m_reloadFragSource);
+    }
+    if (!m_pendingProg) {
+        return false;
+    }
+    if (m_parallelCompile) {
+        // Ask whether the driver is done without making it finish right now
+        GLint done = GL_FALSE;
+        context->glGetProgramiv(m_pendingProg, GL_COMPLETION_STATUS_KHR, &done);
+        if (!done) {
+            return false;
+        }
+    }
+    if (!checkLinked(m_pendingProg, m_pendingVertShader, m_pendingFragShader)) {
+        qDebug() << "Shader reload failed, keeping the previous program";
+        discardReload();
+        return false;
+    }
+
+    // Swap in the new program
+    context->glDeleteProgram(m_prog);
+    context->glDeleteShader(m_vertShader);
+    context->glDeleteShader(m_fragShader);
+    m_prog = m_pendingProg;
+    m_vertShader = m_pendingVertShader;
+    m_fragShader = m_pendingFragShader;
+    m_pendingProg = m_pendingVertShader = m_pendingFragShader = 0;
+    findLocations();
+    return true;
+}
+
+bool ShaderProgram::reloadBlocks() const
+{
+    return !m_parallelCompile && !m_threadedCompile;
+}
+
+void ShaderProgram::discardReload()
+{
+    // Deleting handle 0 is silently ignored by OpenGL
+    context->glDeleteProgram(m_pendingProg);
+    context->glDeleteShader(m_pendingVertShader);
+    context->glDeleteShader(m_pendingFragShader);
+    m_pendingProg = m_pendingVertShader = m_pendingFragShader = 0;
+}
+
 void ShaderProgram::useMe()
 {
     context->glUseProgram(m_prog);
@@ -73,7 +189,15 @@ void ShaderProgram::setModelMatrix(const glm::mat3 &model)
 {
     useMe();
 
-    if (m_unifModel != -1)
+    if (m_attrModel != -1)
+    {
+        // With its arrays disabled, every vertex reads this constant value
+        for (int col = 0; col < 3; col++)
+        {
+            context->glVertexAttrib3fv(m_attrModel + col, &model[col][0]);
+        }
+    }
+    else if (m_unifModel != -1)
     {
         // Pass a 3x3 matrix into a uniform variable in our shader
                         // Handle to the matrix variable on the GPU
@@ -137,7 +261,8 @@ void ShaderProgram::draw(OpenGLContext &f, Drawable &d)
     // Bind the index buffer and then draw shapes from it.
     // This invokes the shader program, which accesses the vertex buffers.
     d.bindIdx();
-    f.glDrawElements(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT, 0);
+    f.glDrawElementsBaseVertex(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT,
+                               reinterpret_cast<void*>(d.firstIndex() * sizeof(GLuint)), d.baseVertex());
 
     if (m_attrPos != -1) context->glDisableVertexAttribArray(m_attrPos);
     if (m_attrCol != -1) context->glDisableVertexAttribArray(m_attrCol);
@@ -145,6 +270,41 @@ void ShaderProgram::draw(OpenGLContext &f, Drawable &d)
     f.printGLErrorLog();
 }
 
+void ShaderProgram::beginShared(GeometryBuffer &buffer)
+{
+    useMe();
+
+    if (m_attrPos != -1 && buffer.bindPos())
+    {
+        context->glEnableVertexAttribArray(m_attrPos);
+        context->glVertexAttribPointer(m_attrPos, 3, GL_FLOAT, false, 0, NULL);
+    }
+    // With its array disabled, vs_Col reads the constant set by drawShared
+    if (m_attrCol != -1) context->glDisableVertexAttribArray(m_attrCol);
+
+    buffer.bindIdx();
+}
+
+void ShaderProgram::drawShared(OpenGLContext &f, Drawable &d, const glm::vec3 &color)
+{
+    if(d.elemCount() < 0) {
+        throw std::invalid_argument(
+        "Attempting to draw a Drawable that has not initialized its count variable! Remember to set it to the length of your index array in create()."
+        );
+    }
+
+    if (m_attrCol != -1) context->glVertexAttrib3f(m_attrCol, color.r, color.g, color.b);
+    f.glDrawElementsBaseVertex(d.drawMode(), d.elemCount(), GL_UNSIGNED_INT,
+                               reinterpret_cast<void*>(d.firstIndex() * sizeof(GLuint)), d.baseVertex());
+}
+
+void ShaderProgram::endShared()
+{
+    if (m_attrPos != -1) context->glDisableVertexAttribArray(m_attrPos);
+
+    context->printGLErrorLog();
+}
+
 char* ShaderProgram::textFileRead(const char* fileName) {
     char* text;
 
@@ -169,6 +329,17 @@ char* ShaderProgram::textFileRead(const char* fileName) {
 
 
 
+QByteArray ShaderProgram::fileRead(const char *fileName)
+{
+    QByteArray text;
+    QFile file(fileName);
+    if (file.open(QFile::ReadOnly))
+    {
+        text = file.readAll();
+    }
+    return text;
+}
+
 QString ShaderProgram::qTextFileRead(const char *fileName)
 {
     QString text;
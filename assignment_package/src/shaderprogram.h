@@ -6,8 +6,11 @@
 
 #include <QOpenGLFunctions_3_2_Core>
 #include <QOpenGLShaderProgram>
+#include <smartpointerhelp.h>
 #include "drawable.h"
 
+class BackgroundShaderCompiler;
+
 
 class ShaderProgram
 {
@@ -19,13 +22,29 @@ public:
     int m_attrPos; // A handle for the "in" vec3 representing vertex position in the vertex shader
     int m_attrCol; // A handle for the "in" vec3 representing vertex color in the vertex shader
 
-    int m_unifModel; // A handle for the "uniform" mat3 representing model matrix in the vertex shader
+    int m_attrModel; // A handle for the "in" mat3 representing the model matrix in the vertex shader.
+                     // Occupies three locations, one per column.
+
+    int m_unifModel; // A handle for the "uniform" mat3 representing model matrix, for shaders that don't use m_attrModel
     int m_unifView; // A handle for the "uniform" mat3 representing the matrix used to scale geometry to the desired size in the vertex shader
 
 public:
     ShaderProgram(OpenGLContext* context);
+    ~ShaderProgram();
     // Sets up the requisite GL data and shaders from the given .glsl files
     void create(const char *vertfile, const char *fragfile);
+    // Starts compiling and linking a replacement for this program from the given source text.
+    // The current program stays in use until pollReload() reports that the replacement is ready.
+    void beginReload(const QByteArray& vertSource, const QByteArray& fragSource);
+    // Checks on the replacement started by beginReload(), without waiting for the driver if it
+    // supports KHR_parallel_shader_compile. Without it, the replacement is built on a worker
+    // thread with a context of its own (see BackgroundShaderCompiler), where the platform allows.
+    // Returns true once the replacement linked and has been swapped in; uniforms must then be
+    // set again. If it failed to build, the errors are printed and the old program is kept.
+    bool pollReload();
+    // True if a reload stalls the calling thread until the driver has compiled and linked,
+    // because neither KHR_parallel_shader_compile nor a worker thread context is available
+    bool reloadBlocks() const;
     // Tells our OpenGL context to use this shader to draw things
     void useMe();
     // Pass the given model matrix to this shader on the GPU
@@ -34,16 +53,47 @@ public:
     void setViewMatrix(const glm::mat3 &vp);
     // Draw the given object to our screen using this ShaderProgram's shaders
     void draw(OpenGLContext &f, Drawable &d);
+    // Binds the given shared buffer once for any number of drawShared calls
+    void beginShared(GeometryBuffer &buffer);
+    // Draws d, which must live in the buffer passed to beginShared, in a single color.
+    // Issues only the draw call: no buffers are bound and no color buffer is uploaded.
+    void drawShared(OpenGLContext &f, Drawable &d, const glm::vec3 &color);
+    // Restores the attribute state changed by beginShared
+    void endShared();
     // Utility function used in create()
     char* textFileRead(const char*);
     // Utility function used in create()
     QString qTextFileRead(const char*);
+    // Utility function used in create(). Returns the raw bytes of the file, which may be a Qt resource
+    QByteArray fileRead(const char*);
     // Utility function that prints any shader compilation errors to the console
     void printShaderInfoLog(int shader);
     // Utility function that prints any shader linking errors to the console
     void printLinkInfoLog(int prog);
 
+    // Creates and compiles two shaders from the given sources and links them into prog,
+    // using the context gl belongs to, which must be current.
+    // Doesn't check the result, so the driver may still be working when this returns.
+    static void compileAndLink(QOpenGLFunctions_3_2_Core& gl, const QByteArray& vertSource, const QByteArray& fragSource,
+                               GLuint prog, GLuint* vertShader, GLuint* fragShader);
+
 private:
+    // Prints any compile / link errors of the given program and returns whether it linked
+    bool checkLinked(GLuint prog, GLuint vertShader, GLuint fragShader);
+    // Looks up the attribute and uniform handles of m_prog
+    void findLocations();
+    // Deletes the replacement program started by beginReload(), if any
+    void discardReload();
+
+    GLuint m_pendingVertShader; // Shaders and program being built by beginReload(), or 0
+    GLuint m_pendingFragShader;
+    GLuint m_pendingProg;
+    bool m_parallelCompile; // True if the driver can report whether a link has finished without blocking
+    bool m_threadedCompile; // True if reloads may be built by mp_compiler
+    uPtr<BackgroundShaderCompiler> mp_compiler; // Made by the first reload that needs it
+    QByteArray m_reloadVertSource; // Sources of the newest reload given to mp_compiler
+    QByteArray m_reloadFragSource;
+
     OpenGLContext* context;   // Since Qt's OpenGL support is done through classes like QOpenGLFunctions_3_2_Core,
                             // we need to pass our OpenGL context to the Drawable in order to call GL functions
                             // from within this class.
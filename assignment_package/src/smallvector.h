@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <utility>
+
+// A vector that stores up to N elements inside itself and only allocates when it
+// grows past that. The heap pointer shares space with the inline elements, so for
+// pointer-sized T and N = 1 it is 16 bytes, against 24 for std::vector, and holds
+// one element without an allocation.
+// Only what Node's children need: elements are moved, never copied, and neither is the vector.
+template<typename T, unsigned int N>
+class SmallVector
+{
+public:
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    SmallVector() : m_size(0), m_capacity(N) {}
+    ~SmallVector()
+    {
+        clear();
+        if (!isInline()) {
+            ::operator delete(mp_heap);
+        }
+    }
+    SmallVector(const SmallVector&) = delete;
+    SmallVector& operator=(const SmallVector&) = delete;
+
+    T* data() { return isInline() ? reinterpret_cast<T*>(m_inline) : mp_heap; }
+    const T* data() const { return isInline() ? reinterpret_cast<const T*>(m_inline) : mp_heap; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + m_size; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + m_size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    std::size_t size() const { return m_size; }
+    std::size_t capacity() const { return m_capacity; }
+    bool empty() const { return m_size == 0; }
+    // Bytes allocated outside the vector itself
+    std::size_t heapBytes() const { return isInline() ? 0 : m_capacity * sizeof(T); }
+
+    T& operator[](std::size_t i) { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    T& back() { return data()[m_size - 1]; }
+    const T& back() const { return data()[m_size - 1]; }
+
+    void reserve(std::size_t capacity)
+    {
+        if (capacity > m_capacity) {
+            reallocate(capacity);
+        }
+    }
+
+    void push_back(T&& value)
+    {
+        if (m_size == m_capacity) {
+            reallocate(2 * std::size_t(m_capacity));
+        }
+        new (data() + m_size) T(std::move(value));
+        m_size++;
+    }
+
+    void pop_back()
+    {
+        m_size--;
+        data()[m_size].~T();
+    }
+
+    // Removes the element at pos, keeping the order of the rest
+    iterator erase(iterator pos)
+    {
+        for (iterator it = pos; it + 1 != end(); ++it) {
+            *it = std::move(*(it + 1));
+        }
+        pop_back();
+        return pos;
+    }
+
+    void clear()
+    {
+        while (m_size) {
+            pop_back();
+        }
+    }
+
+private:
+    bool isInline() const { return m_capacity == N; }
+
+    void reallocate(std::size_t capacity)
+    {
+        T* heap = static_cast<T*>(::operator new(capacity * sizeof(T)));
+        T* old = data();
+        for (std::uint32_t i = 0; i < m_size; i++) {
+            new (heap + i) T(std::move(old[i]));
+            old[i].~T();
+        }
+        if (!isInline()) {
+            ::operator delete(mp_heap);
+        }
+        mp_heap = heap;
+        m_capacity = std::uint32_t(capacity);
+    }
+
+    union {
+        T* mp_heap;                                   // Once the elements outgrew m_inline
+        alignas(T) unsigned char m_inline[N * sizeof(T)];
+    };
+    std::uint32_t m_size;
+    std::uint32_t m_capacity; // N while the elements are stored inline
+};
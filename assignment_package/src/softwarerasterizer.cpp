@@ -0,0 +1,226 @@
+#include "softwarerasterizer.h"
+#include "parallelfor.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Width and height in pixels of the squares the image is split into for binning and threading
+const static int TILE_SIZE = 64;
+// Vertices are snapped to 1 / (1 << SUBPIXEL_BITS) of a pixel
+const static int SUBPIXEL_BITS = 4;
+const static std::int64_t SUBPIXEL = 1 << SUBPIXEL_BITS;
+// Vertices further than this many pixels off the image are moved in to this distance,
+// so that the edge functions stay within 64 bits
+const static float MAX_PIXEL_COORD = float(1 << 25);
+
+// Rounds a / b towards negative infinity (b > 0)
+static std::int64_t floorDiv(std::int64_t a, std::int64_t b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static std::uint32_t packColor(const glm::vec3& color)
+{
+    glm::vec3 c = glm::clamp(color, 0.f, 1.f) * 255.f + 0.5f;
+    return 0xff000000u | (std::uint32_t(c.r) << 16) | (std::uint32_t(c.g) << 8) | std::uint32_t(c.b);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned int threadCount)
+    : m_threadCount(resolveThreadCount(threadCount)),
+      m_width(0), m_height(0), m_tilesX(0), m_tilesY(0), m_view(1.f), m_clearColor(0xff000000u),
+      m_triangles(), m_bins(), m_pixels(), m_scratch()
+{}
+
+void SoftwareRasterizer::beginFrame(int width, int height, const glm::mat3& view, const glm::vec3& clearColor)
+{
+    m_width = std::max(width, 0);
+    m_height = std::max(height, 0);
+    m_tilesX = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+    m_view = view;
+    m_clearColor = packColor(clearColor);
+
+    // Every tile clears itself in endFrame(), so the old contents can stay
+    m_pixels.resize(std::size_t(m_width) * m_height);
+    m_triangles.clear();
+    // Keep the bins' memory from the last frame
+    m_bins.resize(std::size_t(m_tilesX) * m_tilesY);
+    for (std::vector<std::uint32_t>& bin : m_bins) {
+        bin.clear();
+    }
+}
+
+glm::vec2 SoftwareRasterizer::toPixel(const glm::mat3& modelView, const glm::vec3& p) const
+{
+    glm::vec2 ndc(modelView * p);
+    return glm::vec2((ndc.x + 1.f) * 0.5f * m_width, (1.f - ndc.y) * 0.5f * m_height);
+}
+
+void SoftwareRasterizer::drawTriangles(const std::vector<glm::vec3>& positions,
+                                       const std::vector<std::uint32_t>& indices,
+                                       const glm::mat3& model, const glm::vec3& color)
+{
+    glm::mat3 modelView = m_view * model;
+    m_scratch.resize(positions.size());
+    for (std::size_t i = 0; i < positions.size(); i++) {
+        m_scratch[i] = toPixel(modelView, positions[i]);
+    }
+
+    std::uint32_t packed = packColor(color);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+        addTriangle(m_scratch[indices[i]], m_scratch[indices[i + 1]], m_scratch[indices[i + 2]], packed);
+    }
+}
+
+void SoftwareRasterizer::drawLines(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& colors,
+                                   const glm::mat3& model)
+{
+    glm::mat3 modelView = m_view * model;
+    for (std::size_t i = 0; i + 1 < positions.size(); i += 2) {
+        glm::vec2 a = toPixel(modelView, positions[i]);
+        glm::vec2 b = toPixel(modelView, positions[i + 1]);
+        glm::vec2 d = b - a;
+        float length = glm::length(d);
+        if (length < 1e-6f) {
+            continue;
+        }
+        // A one pixel wide rectangle centered on the segment
+        glm::vec2 n = glm::vec2(-d.y, d.x) * (0.5f / length);
+        std::uint32_t packed = packColor(colors[i]);
+        addTriangle(a + n, a - n, b - n, packed);
+        addTriangle(a + n, b - n, b + n, packed);
+    }
+}
+
+void SoftwareRasterizer::addTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c,
+                                     std::uint32_t color)
+{
+    Triangle t;
+    const glm::vec2* v[3] = {&a, &b, &c};
+    for (int i = 0; i < 3; i++) {
+        t.x[i] = std::llround(glm::clamp(v[i]->x, -MAX_PIXEL_COORD, MAX_PIXEL_COORD) * SUBPIXEL);
+        t.y[i] = std::llround(glm::clamp(v[i]->y, -MAX_PIXEL_COORD, MAX_PIXEL_COORD) * SUBPIXEL);
+    }
+
+    std::int64_t area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+    if (area == 0) {
+        return;
+    }
+    if (area < 0) {
+        std::swap(t.x[1], t.x[2]);
+        std::swap(t.y[1], t.y[2]);
+    }
+
+    // The pixels whose centers (x + 0.5, y + 0.5) may be inside
+    const std::int64_t half = SUBPIXEL / 2;
+    std::int64_t minX = -floorDiv(-(std::min({t.x[0], t.x[1], t.x[2]}) - half), SUBPIXEL);
+    std::int64_t minY = -floorDiv(-(std::min({t.y[0], t.y[1], t.y[2]}) - half), SUBPIXEL);
+    std::int64_t maxX = floorDiv(std::max({t.x[0], t.x[1], t.x[2]}) - half, SUBPIXEL);
+    std::int64_t maxY = floorDiv(std::max({t.y[0], t.y[1], t.y[2]}) - half, SUBPIXEL);
+    t.minX = int(std::max<std::int64_t>(minX, 0));
+    t.minY = int(std::max<std::int64_t>(minY, 0));
+    t.maxX = int(std::min<std::int64_t>(maxX, m_width - 1));
+    t.maxY = int(std::min<std::int64_t>(maxY, m_height - 1));
+    if (t.minX > t.maxX || t.minY > t.maxY) {
+        return;
+    }
+    t.color = color;
+
+    std::uint32_t index = std::uint32_t(m_triangles.size());
+    m_triangles.push_back(t);
+    for (int ty = t.minY / TILE_SIZE; ty <= t.maxY / TILE_SIZE; ty++) {
+        for (int tx = t.minX / TILE_SIZE; tx <= t.maxX / TILE_SIZE; tx++) {
+            m_bins[std::size_t(ty) * m_tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::fillTile(int tile)
+{
+    int tileX0 = (tile % m_tilesX) * TILE_SIZE;
+    int tileY0 = (tile / m_tilesX) * TILE_SIZE;
+    int tileX1 = std::min(tileX0 + TILE_SIZE, m_width) - 1;
+    int tileY1 = std::min(tileY0 + TILE_SIZE, m_height) - 1;
+
+    for (int y = tileY0; y <= tileY1; y++) {
+        std::uint32_t* row = m_pixels.data() + std::size_t(y) * m_width;
+        std::fill(row + tileX0, row + tileX1 + 1, m_clearColor);
+    }
+
+    for (std::uint32_t index : m_bins[tile]) {
+        const Triangle& t = m_triangles[index];
+        int x0 = std::max(t.minX, tileX0);
+        int y0 = std::max(t.minY, tileY0);
+        int x1 = std::min(t.maxX, tileX1);
+        int y1 = std::min(t.maxY, tileY1);
+
+        // Edge functions at the center of pixel (x0, y0), and how much they change per pixel.
+        // An edge function is positive on the inside of its edge and 0 on it. A pixel centered
+        // on an edge is only covered for "top-left" edges, so that of two triangles sharing the
+        // edge (which run it in opposite directions) exactly one covers it.
+        std::int64_t rowStart[3], stepX[3], stepY[3];
+        std::int64_t px = std::int64_t(x0) * SUBPIXEL + SUBPIXEL / 2;
+        std::int64_t py = std::int64_t(y0) * SUBPIXEL + SUBPIXEL / 2;
+        for (int i = 0; i < 3; i++) {
+            int j = (i + 1) % 3;
+            std::int64_t dx = t.x[j] - t.x[i];
+            std::int64_t dy = t.y[j] - t.y[i];
+            bool topLeft = dy > 0 || (dy == 0 && dx < 0);
+            rowStart[i] = dx * (py - t.y[i]) - dy * (px - t.x[i]) - (topLeft ? 0 : 1);
+            stepX[i] = -dy * SUBPIXEL;
+            stepY[i] = dx * SUBPIXEL;
+        }
+
+        for (int y = y0; y <= y1; y++) {
+            std::uint32_t* row = m_pixels.data() + std::size_t(y) * m_width;
+            std::int64_t e0 = rowStart[0], e1 = rowStart[1], e2 = rowStart[2];
+            for (int x = x0; x <= x1; x++) {
+                // All three are >= 0 exactly when none has its sign bit set
+                if ((e0 | e1 | e2) >= 0) {
+                    row[x] = t.color;
+                }
+                e0 += stepX[0];
+                e1 += stepX[1];
+                e2 += stepX[2];
+            }
+            rowStart[0] += stepY[0];
+            rowStart[1] += stepY[1];
+            rowStart[2] += stepY[2];
+        }
+    }
+}
+
+void SoftwareRasterizer::endFrame()
+{
+    // Each tile only writes its own pixels
+    parallelFor(m_tilesX * m_tilesY, m_threadCount, [this](int tile) { fillTile(tile); });
+}
+
+int SoftwareRasterizer::width() const
+{
+    return m_width;
+}
+
+int SoftwareRasterizer::height() const
+{
+    return m_height;
+}
+
+const std::vector<std::uint32_t>& SoftwareRasterizer::pixels() const
+{
+    return m_pixels;
+}
+
+QImage SoftwareRasterizer::toImage() const
+{
+    QImage image(m_width, m_height, QImage::Format_RGB32);
+    for (int y = 0; y < m_height; y++) {
+        std::memcpy(image.scanLine(y), m_pixels.data() + std::size_t(y) * m_width, m_width * sizeof(std::uint32_t));
+    }
+    return image;
+}
+
+std::size_t SoftwareRasterizer::triangleCount() const
+{
+    return m_triangles.size();
+}
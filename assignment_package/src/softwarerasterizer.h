@@ -0,0 +1,67 @@
+#pragma once
+
+#include "renderbackend.h"
+#include <QImage>
+
+// Renders on the CPU, for machines without a GPU (CI, batch thumbnails).
+// Draws are transformed and sorted into square tiles of the image as they
+// are made ("binning"); endFrame() then fills the tiles on several threads
+// at once. A tile's triangles are drawn in submission order, so overlaps
+// look the same as with OpenGL.
+// Coverage follows OpenGL's rules: a pixel is inside a triangle if its center
+// is, and pixels centered exactly on an edge shared by two triangles belong to
+// exactly one of them. Vertices are snapped to 1/16 of a pixel.
+class SoftwareRasterizer : public RenderBackend
+{
+public:
+    // threadCount workers fill the tiles; 0 uses one per hardware thread
+    explicit SoftwareRasterizer(unsigned int threadCount = 0);
+
+    void beginFrame(int width, int height, const glm::mat3& view, const glm::vec3& clearColor) override;
+    void drawTriangles(const std::vector<glm::vec3>& positions, const std::vector<std::uint32_t>& indices,
+                       const glm::mat3& model, const glm::vec3& color) override;
+    void drawLines(const std::vector<glm::vec3>& positions, const std::vector<glm::vec3>& colors,
+                   const glm::mat3& model) override;
+    void endFrame() override;
+
+    int width() const;
+    int height() const;
+    // The finished frame, one 0xffRRGGBB value per pixel, rows from top to bottom.
+    // Valid after endFrame().
+    const std::vector<std::uint32_t>& pixels() const;
+    // A copy of pixels() as a QImage::Format_RGB32 image
+    QImage toImage() const;
+
+    // Triangles binned in the current frame
+    std::size_t triangleCount() const;
+
+private:
+    // A triangle ready to be filled: vertices in 1/16 pixel units, wound so its area is positive
+    struct Triangle {
+        std::int64_t x[3];
+        std::int64_t y[3];
+        int minX, minY, maxX, maxY; // Pixels that may be covered, inclusive, clipped to the image
+        std::uint32_t color;
+    };
+
+    // Snaps a vertex already in pixel coordinates and bins the triangle into every tile its box touches
+    void addTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, std::uint32_t color);
+    // Scene coordinates -> pixel coordinates (y pointing down)
+    glm::vec2 toPixel(const glm::mat3& modelView, const glm::vec3& p) const;
+    // Clears tile number tile and draws the triangles binned into it
+    void fillTile(int tile);
+
+    unsigned int m_threadCount;
+
+    int m_width;
+    int m_height;
+    int m_tilesX;
+    int m_tilesY;
+    glm::mat3 m_view;
+    std::uint32_t m_clearColor;
+
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<std::uint32_t>> m_bins; // Per tile, indices into m_triangles in draw order
+    std::vector<std::uint32_t> m_pixels;
+    std::vector<glm::vec2> m_scratch; // One draw's vertices in pixel coordinates
+};
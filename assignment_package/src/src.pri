@@ -4,23 +4,69 @@ DEPENDPATH += $$PWD
 SOURCES += \
     $$PWD/main.cpp \
     $$PWD/mainwindow.cpp \
+    $$PWD/scenetree.cpp \
     $$PWD/mygl.cpp \
     $$PWD/scene/node.cpp \
+    $$PWD/scene/nametable.cpp \
     $$PWD/shaderprogram.cpp \
     $$PWD/la.cpp \
     $$PWD/drawable.cpp \
+    $$PWD/geometrybuffer.cpp \
+    $$PWD/batchrenderer.cpp \
+    $$PWD/streambuffer.cpp \
+    $$PWD/renderqueue.cpp \
+    $$PWD/camera.cpp \
+    $$PWD/renderbackend.cpp \
+    $$PWD/softwarerasterizer.cpp \
+    $$PWD/thumbnailbatch.cpp \
+    $$PWD/frameprofiler.cpp \
+    $$PWD/hudoverlay.cpp \
+    $$PWD/memoryreport.cpp \
     $$PWD/scene/grid.cpp \
     $$PWD/scene/polygon.cpp \
-    $$PWD/openglcontext.cpp
+    $$PWD/scene/triangulate.cpp \
+    $$PWD/scene/geometryregistry.cpp \
+    $$PWD/scene/scenefile.cpp \
+    $$PWD/scene/scenebuilder.cpp \
+    $$PWD/scene/scenechangelog.cpp \
+    $$PWD/openglcontext.cpp \
+    $$PWD/commandjournal.cpp \
+    $$PWD/nodeselection.cpp \
+    $$PWD/programbinarycache.cpp \
+    $$PWD/backgroundshadercompiler.cpp
 
 HEADERS += \
     $$PWD/la.h \
     $$PWD/mainwindow.h \
+    $$PWD/scenetree.h \
     $$PWD/mygl.h \
     $$PWD/scene/node.h \
+    $$PWD/scene/nametable.h \
     $$PWD/shaderprogram.h \
     $$PWD/drawable.h \
+    $$PWD/geometrybuffer.h \
+    $$PWD/batchrenderer.h \
+    $$PWD/streambuffer.h \
+    $$PWD/renderqueue.h \
+    $$PWD/camera.h \
+    $$PWD/renderbackend.h \
+    $$PWD/softwarerasterizer.h \
+    $$PWD/thumbnailbatch.h \
+    $$PWD/frameprofiler.h \
+    $$PWD/hudoverlay.h \
+    $$PWD/memoryreport.h \
     $$PWD/scene/grid.h \
     $$PWD/scene/polygon.h \
+    $$PWD/scene/triangulate.h \
+    $$PWD/scene/geometryregistry.h \
+    $$PWD/scene/scenefile.h \
+    $$PWD/scene/scenebuilder.h \
+    $$PWD/scene/scenechangelog.h \
     $$PWD/openglcontext.h \
-    $$PWD/smartpointerhelp.h
+    $$PWD/smartpointerhelp.h \
+    $$PWD/smallvector.h \
+    $$PWD/parallelfor.h \
+    $$PWD/commandjournal.h \
+    $$PWD/nodeselection.h \
+    $$PWD/programbinarycache.h \
+    $$PWD/backgroundshadercompiler.h
@@ -0,0 +1,137 @@
+#include "streambuffer.h"
+#include <QOpenGLContext>
+
+// From ARB_buffer_storage, in case the GL headers predate it
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// How long one glClientWaitSync call may block, in nanoseconds, before trying again
+const static GLuint64 FENCE_TIMEOUT_NS = 1000000;
+
+StreamBuffer::StreamBuffer(OpenGLContext* context, GLenum target)
+    : m_target(target), m_buffer(0), m_sectionSize(0), m_section(-1),
+      m_fences(), mp_persistent(nullptr), m_bufferStorage(nullptr),
+      mp_context(context)
+{
+    m_fences.fill(nullptr);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    destroy();
+}
+
+void StreamBuffer::create(GLsizeiptr sectionSize)
+{
+    destroy();
+
+    if (!m_bufferStorage) {
+        QOpenGLContext* ctx = QOpenGLContext::currentContext();
+        QSurfaceFormat form = ctx->format();
+        bool core44 = form.majorVersion() > 4 || (form.majorVersion() == 4 && form.minorVersion() >= 4);
+        if (core44 || ctx->hasExtension("GL_ARB_buffer_storage")) {
+            m_bufferStorage = reinterpret_cast<BufferStorageFn>(ctx->getProcAddress("glBufferStorage"));
+        }
+    }
+
+    m_sectionSize = sectionSize;
+    m_section = -1;
+    GLsizeiptr total = m_sectionSize * SECTION_COUNT;
+    mp_context->glGenBuffers(1, &m_buffer);
+    mp_context->glBindBuffer(m_target, m_buffer);
+    if (m_bufferStorage) {
+        // Coherent, so writes reach the GPU without an explicit flush
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        m_bufferStorage(m_target, total, nullptr, flags);
+        mp_persistent = static_cast<char*>(mp_context->glMapBufferRange(m_target, 0, total, flags));
+    } else {
+        mp_context->glBufferData(m_target, total, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StreamBuffer::destroy()
+{
+    for (int i = 0; i < SECTION_COUNT; i++) {
+        waitFor(i);
+    }
+    if (m_buffer) {
+        if (mp_persistent) {
+            mp_context->glBindBuffer(m_target, m_buffer);
+            mp_context->glUnmapBuffer(m_target);
+        }
+        mp_context->glDeleteBuffers(1, &m_buffer);
+    }
+    m_buffer = 0;
+    mp_persistent = nullptr;
+    m_sectionSize = 0;
+}
+
+void* StreamBuffer::map()
+{
+    m_section = (m_section + 1) % SECTION_COUNT;
+    waitFor(m_section);
+
+    if (mp_persistent) {
+        return mp_persistent + offset();
+    }
+    mp_context->glBindBuffer(m_target, m_buffer);
+    return mp_context->glMapBufferRange(m_target, offset(), m_sectionSize,
+                                        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+void StreamBuffer::unmap()
+{
+    if (!mp_persistent) {
+        mp_context->glBindBuffer(m_target, m_buffer);
+        mp_context->glUnmapBuffer(m_target);
+    }
+}
+
+void StreamBuffer::fence()
+{
+    if (m_section < 0) {
+        return;
+    }
+    if (m_fences[m_section]) {
+        mp_context->glDeleteSync(m_fences[m_section]);
+    }
+    m_fences[m_section] = mp_context->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamBuffer::waitFor(int i)
+{
+    GLsync& sync = m_fences[i];
+    if (!sync) {
+        return;
+    }
+    GLenum result;
+    do {
+        result = mp_context->glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    mp_context->glDeleteSync(sync);
+    sync = nullptr;
+}
+
+GLintptr StreamBuffer::offset() const
+{
+    return m_section < 0 ? 0 : m_section * m_sectionSize;
+}
+
+GLsizeiptr StreamBuffer::sectionSize() const
+{
+    return m_sectionSize;
+}
+
+GLuint StreamBuffer::buffer() const
+{
+    return m_buffer;
+}
+
+bool StreamBuffer::isPersistent() const
+{
+    return mp_persistent != nullptr;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <openglcontext.h>
+#include <array>
+
+// A GPU buffer for data that is rewritten every frame, split into a ring of
+// sections. The CPU writes one section while the GPU may still be reading the
+// others, and a fence per section makes the CPU wait only if it laps the GPU.
+// With OpenGL 4.4 or ARB_buffer_storage the buffer is mapped once and stays
+// mapped; otherwise each section is mapped with glMapBufferRange, unsynchronized
+// (the fences already keep the GPU's reads and the CPU's writes apart).
+class StreamBuffer
+{
+public:
+    // Enough sections for the CPU to stay two frames ahead of the GPU
+    const static int SECTION_COUNT = 3;
+
+    StreamBuffer(OpenGLContext* context, GLenum target);
+    ~StreamBuffer();
+
+    // Allocates SECTION_COUNT sections of sectionSize bytes each, freeing any
+    // previous storage. The context must be current.
+    void create(GLsizeiptr sectionSize);
+    // Waits for the GPU to finish with the buffer, then frees it
+    void destroy();
+
+    // Moves on to the next section and returns sectionSize() writable bytes,
+    // after waiting for the GPU to finish reading that section
+    void* map();
+    // Ends writing the section returned by map(); draw calls may read it from now on
+    void unmap();
+    // Must be called after the draw calls reading the current section have been issued
+    void fence();
+
+    // Byte offset of the current section within buffer()
+    GLintptr offset() const;
+    GLsizeiptr sectionSize() const;
+    GLuint buffer() const;
+    // True if the buffer is mapped once for good rather than once per map()
+    bool isPersistent() const;
+
+private:
+    typedef void (QOPENGLF_APIENTRYP BufferStorageFn)(GLenum, GLsizeiptr, const void*, GLbitfield);
+
+    // Blocks until the GPU has passed the fence of section i
+    void waitFor(int i);
+
+    GLenum m_target;
+    GLuint m_buffer;
+    GLsizeiptr m_sectionSize;
+    int m_section; // Section last returned by map(), or -1 before the first call
+
+    std::array<GLsync, SECTION_COUNT> m_fences; // Signaled once the GPU is done with each section
+    char* mp_persistent; // The whole buffer's mapping if it is persistent, else nullptr
+
+    BufferStorageFn m_bufferStorage;
+    OpenGLContext* mp_context;
+};
@@ -0,0 +1,155 @@
+#include "thumbnailbatch.h"
+#include "softwarerasterizer.h"
+#include "camera.h"
+#include "scene/scenefile.h"
+#include "parallelfor.h"
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Same background as MyGL
+const static glm::vec3 CLEAR_COLOR(0.5f, 0.5f, 0.5f);
+// Render threads per loader thread. Parsing is much cheaper than drawing.
+const static unsigned int RENDERERS_PER_LOADER = 4;
+// Loaded scenes that may wait for a render thread, per render thread
+const static std::size_t QUEUED_PER_RENDERER = 2;
+
+// Computes the box around every polygon of the scene under root, in scene coordinates.
+// Returns false if the scene has no polygon.
+static bool sceneBounds(Node& root, glm::vec2& min, glm::vec2& max)
+{
+    min = glm::vec2(INFINITY);
+    max = glm::vec2(-INFINITY);
+    std::vector<std::pair<Node*, glm::mat3>> stack;
+    stack.emplace_back(&root, glm::mat3(1.f));
+    while (!stack.empty()) {
+        Node* node = stack.back().first;
+        glm::mat3 parentWorld = stack.back().second;
+        stack.pop_back();
+
+        node->updateWorldTransform(parentWorld, true);
+        const glm::mat3& world = node->getWorldTransform();
+        if (Polygon2D* polygon = node->getPolygon()) {
+            for (const glm::vec3& p : polygon->positions()) {
+                glm::vec2 scenePos(world * p);
+                min = glm::min(min, scenePos);
+                max = glm::max(max, scenePos);
+            }
+        }
+        for (const uPtr<Node>& child : node->getChildren()) {
+            stack.emplace_back(child.get(), world);
+        }
+    }
+    return min.x <= max.x;
+}
+
+ThumbnailBatch::ThumbnailBatch(const QString& outputDir, int width, int height, unsigned int threadCount)
+    : m_outputDir(outputDir), m_width(width), m_height(height),
+      m_threadCount(resolveThreadCount(threadCount))
+{}
+
+ThumbnailBatch::LoadedScene ThumbnailBatch::load(const QString& path) const
+{
+    LoadedScene scene;
+    scene.path = path;
+    // No context: the shapes are only ever drawn on the CPU
+    scene.geometry = mkU<GeometryRegistry>(nullptr);
+    scene.root = SceneFile::read(path, *scene.geometry, &scene.error);
+    return scene;
+}
+
+bool ThumbnailBatch::render(const LoadedScene& scene, SoftwareRasterizer& rasterizer) const
+{
+    if (!scene.root) {
+        qWarning() << scene.path << ":" << scene.error;
+        return false;
+    }
+
+    Camera camera;
+    camera.setViewport(m_width, m_height);
+    glm::vec2 min, max;
+    if (sceneBounds(*scene.root, min, max)) {
+        camera.frame(min, max);
+    }
+
+    rasterizer.beginFrame(m_width, m_height, camera.viewMatrix(), CLEAR_COLOR);
+    rasterizer.drawScene(*scene.root);
+    rasterizer.endFrame();
+
+    // The writer encodes straight into the file rather than into memory first
+    QString outputPath = QDir(m_outputDir).filePath(QFileInfo(scene.path).completeBaseName() + ".png");
+    QImageWriter writer(outputPath, "png");
+    if (!writer.write(rasterizer.toImage())) {
+        qWarning() << outputPath << ":" << writer.errorString();
+        return false;
+    }
+    return true;
+}
+
+int ThumbnailBatch::run(const QStringList& scenePaths)
+{
+    const int sceneCount = int(scenePaths.size());
+    const unsigned int loaderCount = std::max(1u, m_threadCount / RENDERERS_PER_LOADER);
+    const std::size_t queueCapacity = QUEUED_PER_RENDERER * m_threadCount;
+
+    std::mutex mutex;
+    std::condition_variable loaded;    // Signaled when a scene is queued or the last loader finishes
+    std::condition_variable dequeued;  // Signaled when a scene leaves the queue
+    std::deque<LoadedScene> queue;
+    unsigned int loadersRunning = loaderCount;
+    std::atomic<int> nextScene(0);
+    std::atomic<int> failed(0);
+
+    auto loader = [&]() {
+        for (int i = nextScene++; i < sceneCount; i = nextScene++) {
+            LoadedScene scene = load(scenePaths[i]);
+            std::unique_lock<std::mutex> lock(mutex);
+            dequeued.wait(lock, [&] { return queue.size() < queueCapacity; });
+            queue.push_back(std::move(scene));
+            lock.unlock();
+            loaded.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        loadersRunning--;
+        loaded.notify_all();
+    };
+
+    auto renderer = [&]() {
+        // Scenes are rendered in parallel with each other, so each one uses a single thread
+        SoftwareRasterizer rasterizer(1);
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            loaded.wait(lock, [&] { return !queue.empty() || loadersRunning == 0; });
+            if (queue.empty()) {
+                return;
+            }
+            LoadedScene scene = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            dequeued.notify_one();
+
+            if (!render(scene, rasterizer)) {
+                failed++;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < loaderCount; i++) {
+        threads.emplace_back(loader);
+    }
+    for (unsigned int i = 0; i < m_threadCount; i++) {
+        threads.emplace_back(renderer);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return failed;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <smartpointerhelp.h>
+#include "scene/node.h"
+#include "scene/geometryregistry.h"
+
+class SoftwareRasterizer;
+
+// Renders PNG previews of many scene files (see SceneFile) without a window or a GPU.
+// Loader threads read and parse the files while render threads draw the scenes
+// already loaded, each with a SoftwareRasterizer of its own, and encode their
+// images straight to disk. A bounded queue between the two keeps loaders from
+// running far ahead of rendering.
+class ThumbnailBatch
+{
+public:
+    // Images are width x height pixels and go to outputDir, which must exist.
+    // threadCount render threads are used; 0 means one per hardware thread.
+    ThumbnailBatch(const QString& outputDir, int width, int height, unsigned int threadCount = 0);
+
+    // Renders each scene in scenePaths to <outputDir>/<file name without extension>.png,
+    // framed to fit the scene. Returns how many scenes failed to load or save.
+    int run(const QStringList& scenePaths);
+
+private:
+    // One scene file, read and waiting to be rendered
+    struct LoadedScene {
+        QString path;
+        // Declared before root so that the nodes release their geometry before it is destroyed
+        uPtr<GeometryRegistry> geometry;
+        uPtr<Node> root; // nullptr if the file couldn't be loaded
+        QString error;
+    };
+
+    LoadedScene load(const QString& path) const;
+    // Draws scene with rasterizer and saves the image. Returns false, with a message printed, on failure.
+    bool render(const LoadedScene& scene, SoftwareRasterizer& rasterizer) const;
+
+    QString m_outputDir;
+    int m_width;
+    int m_height;
+    unsigned int m_threadCount;
+};